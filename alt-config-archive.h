@@ -0,0 +1,713 @@
+#pragma once
+
+#include "alt-config.h"
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <unordered_map>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace alt::config
+{
+	namespace detail
+	{
+		inline uint16_t ReadU16(const uint8_t* p) { return static_cast<uint16_t>(p[0] | (p[1] << 8)); }
+		inline uint32_t ReadU32(const uint8_t* p) { return ReadU16(p) | (static_cast<uint32_t>(ReadU16(p + 2)) << 16); }
+
+		// CRC-32 as stored in zip archives, pass the previous result as crc to
+		// continue it
+		inline uint32_t Crc32(const uint8_t* data, std::size_t size, uint32_t crc = 0)
+		{
+			static const auto table = []() {
+				std::array<uint32_t, 256> result{};
+				for (uint32_t i = 0; i < 256; i++)
+				{
+					uint32_t c = i;
+					for (int bit = 0; bit < 8; bit++)
+						c = c & 1 ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+					result[i] = c;
+				}
+				return result;
+			}();
+
+			crc = ~crc;
+			for (std::size_t i = 0; i < size; i++)
+				crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+			return ~crc;
+		}
+
+		class MappedFile
+		{
+		public:
+			MappedFile(const std::string& path)
+			{
+#ifdef _WIN32
+				file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+				if (file == INVALID_HANDLE_VALUE)
+					throw Error("Failed to open " + path);
+
+				LARGE_INTEGER fileSize;
+				if (!GetFileSizeEx(file, &fileSize))
+				{
+					CloseHandle(file);
+					throw Error("Failed to open " + path);
+				}
+
+				size = static_cast<std::size_t>(fileSize.QuadPart);
+				if (size == 0)
+					return;
+
+				mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+				if (mapping)
+					data = static_cast<const uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+
+				if (!data)
+				{
+					if (mapping) CloseHandle(mapping);
+					CloseHandle(file);
+					throw Error("Failed to map " + path);
+				}
+#else
+				int fd = open(path.c_str(), O_RDONLY);
+				if (fd < 0)
+					throw Error("Failed to open " + path);
+
+				struct stat st;
+				if (fstat(fd, &st) != 0)
+				{
+					close(fd);
+					throw Error("Failed to open " + path);
+				}
+
+				size = static_cast<std::size_t>(st.st_size);
+				if (size > 0)
+				{
+					void* addr = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+					if (addr == MAP_FAILED)
+					{
+						close(fd);
+						throw Error("Failed to map " + path);
+					}
+					data = static_cast<const uint8_t*>(addr);
+				}
+
+				// the mapping stays valid after the descriptor is closed
+				close(fd);
+#endif
+			}
+
+			MappedFile(const MappedFile&) = delete;
+			MappedFile& operator=(const MappedFile&) = delete;
+
+			~MappedFile()
+			{
+#ifdef _WIN32
+				if (data) UnmapViewOfFile(data);
+				if (mapping) CloseHandle(mapping);
+				if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+#else
+				if (data) munmap(const_cast<uint8_t*>(data), size);
+#endif
+			}
+
+			const uint8_t* Data() const { return data; }
+			std::size_t Size() const { return size; }
+
+		private:
+			const uint8_t* data = nullptr;
+			std::size_t size = 0;
+#ifdef _WIN32
+			HANDLE file = INVALID_HANDLE_VALUE;
+			HANDLE mapping = nullptr;
+#endif
+		};
+
+		// Incremental raw deflate (RFC 1951) decoder, output is produced on demand
+		// so only the 32k history window is kept in memory.
+		class Inflater
+		{
+		public:
+			Inflater(const uint8_t* _in, std::size_t _size) :
+				in(_in),
+				inSize(_size),
+				window(WINDOW_SIZE)
+			{
+
+			}
+
+			std::size_t Read(char* out, std::size_t size)
+			{
+				std::size_t n = 0;
+
+				while (n < size)
+				{
+					if (copyLen > 0)
+					{
+						while (copyLen > 0 && n < size)
+						{
+							Put(window[(total - copyDist) & WINDOW_MASK], out, n);
+							copyLen--;
+						}
+						continue;
+					}
+
+					switch (mode)
+					{
+					case Mode::DONE:
+						return n;
+					case Mode::HEADER:
+						if (last)
+						{
+							mode = Mode::DONE;
+							break;
+						}
+						BeginBlock();
+						break;
+					case Mode::STORED:
+						if (storedLeft == 0)
+						{
+							mode = Mode::HEADER;
+							break;
+						}
+						if (inPos >= inSize)
+							throw Error("Unexpected end of deflate stream");
+						Put(in[inPos++], out, n);
+						storedLeft--;
+						break;
+					case Mode::CODES:
+					{
+						int sym = Decode(lencode);
+						if (sym < 256)
+							Put(static_cast<uint8_t>(sym), out, n);
+						else if (sym == 256)
+							mode = Mode::HEADER;
+						else
+						{
+							static const uint16_t lbase[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+							static const uint16_t lext[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+							static const uint16_t dbase[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+							static const uint16_t dext[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+							sym -= 257;
+							if (sym >= 29)
+								throw Error("Invalid deflate length code");
+							copyLen = lbase[sym] + Bits(lext[sym]);
+
+							sym = Decode(distcode);
+							if (sym >= 30)
+								throw Error("Invalid deflate distance code");
+							copyDist = dbase[sym] + Bits(dext[sym]);
+
+							if (copyDist > total)
+								throw Error("Invalid deflate distance");
+						}
+						break;
+					}
+					}
+				}
+
+				return n;
+			}
+
+		private:
+			static constexpr std::size_t WINDOW_SIZE = 32768;
+			static constexpr std::size_t WINDOW_MASK = WINDOW_SIZE - 1;
+
+			enum class Mode
+			{
+				HEADER,
+				STORED,
+				CODES,
+				DONE,
+			};
+
+			struct Huffman
+			{
+				uint16_t count[16];
+				uint16_t symbol[288];
+			};
+
+			void Put(uint8_t c, char* out, std::size_t& n)
+			{
+				window[total++ & WINDOW_MASK] = c;
+				out[n++] = static_cast<char>(c);
+			}
+
+			uint32_t Bits(int need)
+			{
+				uint32_t val = bitBuf;
+				while (bitCount < need)
+				{
+					if (inPos >= inSize)
+						throw Error("Unexpected end of deflate stream");
+					val |= static_cast<uint32_t>(in[inPos++]) << bitCount;
+					bitCount += 8;
+				}
+
+				bitBuf = val >> need;
+				bitCount -= need;
+				return val & ((1u << need) - 1);
+			}
+
+			int Decode(const Huffman& h)
+			{
+				int code = 0;
+				int first = 0;
+				int index = 0;
+
+				for (int len = 1; len < 16; len++)
+				{
+					code |= Bits(1);
+					int count = h.count[len];
+					if (code - count < first)
+						return h.symbol[index + (code - first)];
+					index += count;
+					first += count;
+					first <<= 1;
+					code <<= 1;
+				}
+
+				throw Error("Invalid deflate code");
+			}
+
+			// Returns 0 for a complete code, > 0 for an incomplete and < 0 for an
+			// over-subscribed one
+			static int Build(Huffman& h, const uint16_t* lengths, int n)
+			{
+				uint16_t offs[16];
+
+				std::fill(std::begin(h.count), std::end(h.count), 0);
+				for (int sym = 0; sym < n; sym++)
+					h.count[lengths[sym]]++;
+
+				if (h.count[0] == n)
+					return 0;
+
+				int left = 1;
+				for (int len = 1; len < 16; len++)
+				{
+					left <<= 1;
+					left -= h.count[len];
+					if (left < 0)
+						return left;
+				}
+
+				offs[1] = 0;
+				for (int len = 1; len < 15; len++)
+					offs[len + 1] = offs[len] + h.count[len];
+
+				for (int sym = 0; sym < n; sym++)
+				{
+					if (lengths[sym] != 0)
+						h.symbol[offs[lengths[sym]]++] = static_cast<uint16_t>(sym);
+				}
+
+				return left;
+			}
+
+			void BeginBlock()
+			{
+				last = Bits(1) != 0;
+
+				switch (Bits(2))
+				{
+				case 0:
+				{
+					// stored blocks start at the next byte boundary
+					bitBuf = 0;
+					bitCount = 0;
+
+					if (inSize - inPos < 4)
+						throw Error("Unexpected end of deflate stream");
+
+					uint16_t len = ReadU16(in + inPos);
+					uint16_t nlen = ReadU16(in + inPos + 2);
+					inPos += 4;
+
+					if (len != static_cast<uint16_t>(~nlen))
+						throw Error("Invalid deflate stored block");
+
+					storedLeft = len;
+					mode = Mode::STORED;
+					break;
+				}
+				case 1:
+				{
+					uint16_t lengths[288];
+					std::fill(lengths, lengths + 144, 8);
+					std::fill(lengths + 144, lengths + 256, 9);
+					std::fill(lengths + 256, lengths + 280, 7);
+					std::fill(lengths + 280, lengths + 288, 8);
+					Build(lencode, lengths, 288);
+
+					std::fill(lengths, lengths + 30, 5);
+					Build(distcode, lengths, 30);
+
+					mode = Mode::CODES;
+					break;
+				}
+				case 2:
+					BuildDynamic();
+					mode = Mode::CODES;
+					break;
+				default:
+					throw Error("Invalid deflate block type");
+				}
+			}
+
+			void BuildDynamic()
+			{
+				static const uint8_t order[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+				uint16_t lengths[320];
+
+				int nlen = Bits(5) + 257;
+				int ndist = Bits(5) + 1;
+				int ncode = Bits(4) + 4;
+
+				if (nlen > 286 || ndist > 30)
+					throw Error("Invalid deflate block");
+
+				int index = 0;
+				for (; index < ncode; index++)
+					lengths[order[index]] = static_cast<uint16_t>(Bits(3));
+				for (; index < 19; index++)
+					lengths[order[index]] = 0;
+
+				if (Build(lencode, lengths, 19) != 0)
+					throw Error("Invalid deflate block");
+
+				index = 0;
+				while (index < nlen + ndist)
+				{
+					int sym = Decode(lencode);
+					if (sym < 16)
+					{
+						lengths[index++] = static_cast<uint16_t>(sym);
+						continue;
+					}
+
+					uint16_t len = 0;
+					if (sym == 16)
+					{
+						if (index == 0)
+							throw Error("Invalid deflate block");
+						len = lengths[index - 1];
+						sym = 3 + Bits(2);
+					}
+					else if (sym == 17)
+						sym = 3 + Bits(3);
+					else
+						sym = 11 + Bits(7);
+
+					if (index + sym > nlen + ndist)
+						throw Error("Invalid deflate block");
+
+					while (sym--)
+						lengths[index++] = len;
+				}
+
+				if (lengths[256] == 0)
+					throw Error("Invalid deflate block");
+
+				int err = Build(lencode, lengths, nlen);
+				if (err < 0 || (err > 0 && nlen - lencode.count[0] != 1))
+					throw Error("Invalid deflate block");
+
+				err = Build(distcode, lengths + nlen, ndist);
+				if (err < 0 || (err > 0 && ndist - distcode.count[0] != 1))
+					throw Error("Invalid deflate block");
+			}
+
+			const uint8_t* in;
+			std::size_t inSize;
+			std::size_t inPos = 0;
+			uint32_t bitBuf = 0;
+			int bitCount = 0;
+
+			Mode mode = Mode::HEADER;
+			bool last = false;
+			std::size_t storedLeft = 0;
+			std::size_t copyLen = 0;
+			std::size_t copyDist = 0;
+			Huffman lencode;
+			Huffman distcode;
+
+			std::vector<uint8_t> window;
+			std::size_t total = 0;
+		};
+
+		class InflateStreamBuf : public std::streambuf
+		{
+		public:
+			// expectedSize and expectedCrc come from the directory, the end of the
+			// stream is only reported once the inflated data matched both
+			InflateStreamBuf(const uint8_t* data, std::size_t size, std::size_t expectedSize, uint32_t expectedCrc, std::size_t chunkSize = 64 * 1024) :
+				inflater(data, size),
+				chunk(chunkSize),
+				expectedSize(expectedSize),
+				expectedCrc(expectedCrc)
+			{
+
+			}
+
+		protected:
+			int_type underflow() override
+			{
+				if (gptr() < egptr())
+					return traits_type::to_int_type(*gptr());
+
+				std::size_t n = inflater.Read(chunk.data(), chunk.size());
+				if (n == 0)
+				{
+					if (total != expectedSize || crc != expectedCrc)
+						throw Error("Corrupted zip archive: checksum mismatch");
+					return traits_type::eof();
+				}
+
+				total += n;
+				if (total > expectedSize)
+					throw Error("Corrupted zip archive: size mismatch");
+				crc = Crc32(reinterpret_cast<const uint8_t*>(chunk.data()), n, crc);
+
+				setg(chunk.data(), chunk.data(), chunk.data() + n);
+				return traits_type::to_int_type(*gptr());
+			}
+
+		private:
+			Inflater inflater;
+			std::vector<char> chunk;
+			std::size_t expectedSize;
+			uint32_t expectedCrc;
+			std::size_t total = 0;
+			uint32_t crc = 0;
+		};
+
+		class MemoryStreamBuf : public std::streambuf
+		{
+		public:
+			MemoryStreamBuf(const char* data, std::size_t size)
+			{
+				char* begin = const_cast<char*>(data);
+				setg(begin, begin, begin + size);
+			}
+		};
+	}
+
+	// Read-only view of a zip archive. The file is memory mapped and the central
+	// directory is indexed once, entries are parsed straight out of the mapping
+	// (stored) or through an incremental inflater (deflated).
+	class Archive
+	{
+	public:
+		struct Entry
+		{
+			std::string name;
+			uint16_t method;
+			uint16_t flags;
+			uint64_t compressedSize;
+			uint64_t size;
+			uint64_t headerOffset;
+			uint32_t crc32;
+		};
+
+		class Stream : public std::istream
+		{
+		public:
+			Stream(std::unique_ptr<std::streambuf> _buf) :
+				std::istream(_buf.get()),
+				buf(std::move(_buf))
+			{
+				// let decompression errors reach the caller
+				exceptions(std::ios::badbit);
+			}
+
+		private:
+			std::unique_ptr<std::streambuf> buf;
+		};
+
+		Archive(const std::string& path) :
+			file(path)
+		{
+			ReadDirectory();
+		}
+
+		const std::vector<Entry>& GetEntries() const { return entries; }
+
+		const Entry* Find(const std::string& name) const
+		{
+			auto it = index.find(name);
+			if (it == index.end())
+				return nullptr;
+			return &entries[it->second];
+		}
+
+		Node Parse(const std::string& name) const
+		{
+			auto entry = Find(name);
+			if (!entry)
+				throw Error("Archive entry not found: " + name);
+			return Parse(*entry);
+		}
+
+		Node Parse(const Entry& entry) const
+		{
+			const uint8_t* data = GetData(entry);
+
+			if (entry.method == STORED)
+			{
+				Verify(entry, data);
+
+				auto begin = reinterpret_cast<const char*>(data);
+				std::size_t size = static_cast<std::size_t>(entry.size);
+
+				// skip BOM header
+				if (size >= 3 && begin[0] == (char)0xEF && begin[1] == (char)0xBB && begin[2] == (char)0xBF)
+				{
+					begin += 3;
+					size -= 3;
+				}
+
+				detail::Scanner<detail::BufferSource> scanner{ begin, size };
+				return Parser::Parse(scanner);
+			}
+
+			auto is = Open(entry);
+			detail::Scanner<detail::StreamSource> scanner{ *is };
+			return Parser::Parse(scanner);
+		}
+
+		// Raw entry contents, e.g. to feed a Reader
+		std::unique_ptr<Stream> Open(const Entry& entry) const
+		{
+			const uint8_t* data = GetData(entry);
+
+			if (entry.method == STORED)
+			{
+				Verify(entry, data);
+				return std::make_unique<Stream>(std::make_unique<detail::MemoryStreamBuf>(reinterpret_cast<const char*>(data), static_cast<std::size_t>(entry.size)));
+			}
+
+			return std::make_unique<Stream>(std::make_unique<detail::InflateStreamBuf>(data, static_cast<std::size_t>(entry.compressedSize),
+				static_cast<std::size_t>(entry.size), entry.crc32));
+		}
+
+	private:
+		static constexpr uint16_t STORED = 0;
+		static constexpr uint16_t DEFLATED = 8;
+
+		void ReadDirectory()
+		{
+			const uint8_t* data = file.Data();
+			std::size_t size = file.Size();
+
+			if (size < 22)
+				throw Error("Not a zip archive");
+
+			// end of central directory record, followed by an up to 64k comment
+			std::size_t eocd = size - 22;
+			std::size_t limit = size > 22 + 0xFFFF ? size - 22 - 0xFFFF : 0;
+			while (detail::ReadU32(data + eocd) != 0x06054b50)
+			{
+				if (eocd == limit)
+					throw Error("Not a zip archive");
+				eocd--;
+			}
+
+			uint16_t count = detail::ReadU16(data + eocd + 10);
+			uint32_t dirSize = detail::ReadU32(data + eocd + 12);
+			uint32_t dirOffset = detail::ReadU32(data + eocd + 16);
+
+			if (count == 0xFFFF || dirOffset == 0xFFFFFFFF)
+				throw Error("ZIP64 archives are not supported");
+
+			if (static_cast<uint64_t>(dirOffset) + dirSize > size)
+				throw Error("Corrupted zip archive");
+
+			entries.reserve(count);
+			index.reserve(count);
+
+			std::size_t pos = dirOffset;
+			for (uint16_t i = 0; i < count; i++)
+			{
+				if (pos + 46 > size || detail::ReadU32(data + pos) != 0x02014b50)
+					throw Error("Corrupted zip archive", pos);
+
+				const uint8_t* header = data + pos;
+				uint16_t nameLen = detail::ReadU16(header + 28);
+				uint16_t extraLen = detail::ReadU16(header + 30);
+				uint16_t commentLen = detail::ReadU16(header + 32);
+
+				if (pos + 46 + nameLen > size)
+					throw Error("Corrupted zip archive", pos);
+
+				Entry entry;
+				entry.name.assign(reinterpret_cast<const char*>(header + 46), nameLen);
+				entry.flags = detail::ReadU16(header + 8);
+				entry.method = detail::ReadU16(header + 10);
+				entry.crc32 = detail::ReadU32(header + 16);
+				entry.compressedSize = detail::ReadU32(header + 20);
+				entry.size = detail::ReadU32(header + 24);
+				entry.headerOffset = detail::ReadU32(header + 42);
+
+				index.emplace(entry.name, entries.size());
+				entries.push_back(std::move(entry));
+
+				pos += 46 + nameLen + extraLen + commentLen;
+			}
+		}
+
+		const uint8_t* GetData(const Entry& entry) const
+		{
+			if (entry.flags & 1)
+				throw Error("Encrypted archive entries are not supported: " + entry.name);
+
+			if (entry.method != STORED && entry.method != DEFLATED)
+				throw Error("Unsupported compression method: " + entry.name);
+
+			const uint8_t* data = file.Data();
+			std::size_t size = file.Size();
+			uint64_t pos = entry.headerOffset;
+
+			if (pos + 30 > size || detail::ReadU32(data + pos) != 0x04034b50)
+				throw Error("Corrupted zip archive: " + entry.name);
+
+			pos += 30 + detail::ReadU16(data + pos + 26) + detail::ReadU16(data + pos + 28);
+
+			// stored entries are read with their uncompressed size
+			if (entry.method == STORED && entry.size != entry.compressedSize)
+				throw Error("Corrupted zip archive: " + entry.name);
+
+			if (pos + entry.compressedSize > size)
+				throw Error("Corrupted zip archive: " + entry.name);
+
+			return data + pos;
+		}
+
+		static void Verify(const Entry& entry, const uint8_t* data)
+		{
+			if (detail::Crc32(data, static_cast<std::size_t>(entry.size)) != entry.crc32)
+				throw Error("Corrupted zip archive: checksum mismatch in " + entry.name);
+		}
+
+		detail::MappedFile file;
+		std::vector<Entry> entries;
+		std::unordered_map<std::string, std::size_t> index;
+	};
+};
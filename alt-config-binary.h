@@ -0,0 +1,636 @@
+#pragma once
+
+#include "alt-config.h"
+
+#include <cerrno>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <memory>
+
+namespace alt::config
+{
+	namespace detail
+	{
+		// List or dict being decoded, the children are deleted if decoding
+		// fails. It is filled directly since the container of a Node handed out
+		// by ToList() / ToDict() is kept out of the caches.
+		template<class Container>
+		struct Children
+		{
+			~Children()
+			{
+				for (auto& curr : val)
+				{
+					if constexpr (std::is_same_v<Container, Node::List>)
+						delete curr;
+					else
+						delete curr.second;
+				}
+			}
+
+			Node* Release()
+			{
+				Node* node = new Node(std::move(val));
+				val = {};
+				return node;
+			}
+
+			Container val;
+		};
+
+		class ByteReader
+		{
+		public:
+			ByteReader(std::istream& _is) : is(_is) { }
+
+			uint8_t Byte()
+			{
+				auto c = is.get();
+				if (c == std::istream::traits_type::eof())
+					throw Error("Unexpected end of data");
+				return static_cast<uint8_t>(c);
+			}
+
+			uint64_t BigEndian(std::size_t n)
+			{
+				uint64_t res = 0;
+				for (std::size_t i = 0; i < n; i++)
+					res = (res << 8) | Byte();
+				return res;
+			}
+
+			double Float32()
+			{
+				uint32_t bits = static_cast<uint32_t>(BigEndian(4));
+				float res;
+				std::memcpy(&res, &bits, sizeof(res));
+				return res;
+			}
+
+			double Float64()
+			{
+				uint64_t bits = BigEndian(8);
+				double res;
+				std::memcpy(&res, &bits, sizeof(res));
+				return res;
+			}
+
+			std::string Bytes(uint64_t n)
+			{
+				// grow with the data instead of trusting the length up front
+				std::string res;
+				while (n > 0)
+				{
+					std::size_t chunk = static_cast<std::size_t>(std::min<uint64_t>(n, 64 * 1024));
+					std::size_t size = res.size();
+					res.resize(size + chunk);
+					if (!is.read(&res[size], chunk))
+						throw Error("Unexpected end of data");
+					n -= chunk;
+				}
+				return res;
+			}
+
+		private:
+			std::istream& is;
+		};
+
+		// Decoded integers are stored natively, ones above the int64_t range as
+		// their exact text since Node(uint64_t) would round them to a double
+		inline Node* NewInteger(uint64_t val)
+		{
+			if (val > static_cast<uint64_t>(std::numeric_limits<int64_t>::max()))
+				return new Node(std::to_string(val));
+			return new Node(static_cast<int64_t>(val));
+		}
+
+		class ByteWriter
+		{
+		public:
+			ByteWriter(std::ostream& _os) : os(_os) { }
+
+			void Byte(uint8_t c) { os.put(static_cast<char>(c)); }
+
+			void BigEndian(uint64_t val, std::size_t n)
+			{
+				char buf[8];
+				for (std::size_t i = 0; i < n; i++)
+					buf[i] = static_cast<char>(val >> ((n - 1 - i) * 8));
+				os.write(buf, n);
+			}
+
+			void Float64(double val)
+			{
+				uint64_t bits;
+				std::memcpy(&bits, &val, sizeof(bits));
+				BigEndian(bits, 8);
+			}
+
+			void Bytes(std::string_view str) { os.write(str.data(), str.size()); }
+
+		private:
+			std::ostream& os;
+		};
+
+		constexpr std::size_t MAX_BINARY_DEPTH = 1024;
+
+		inline std::size_t CountEntries(const Node::Dict& dict)
+		{
+			std::size_t count = 0;
+			for (auto& curr : dict)
+			{
+				if (curr.second && !curr.second->IsNone())
+					count++;
+			}
+			return count;
+		}
+	}
+
+	class MsgPack
+	{
+	public:
+		static void Encode(Node& node, std::ostream& os)
+		{
+			detail::ByteWriter out{ os };
+			Encode(node, out);
+		}
+
+		static Node Decode(std::istream& is)
+		{
+			detail::ByteReader in{ is };
+			std::unique_ptr<Node> root{ Read(in, 0) };
+			return std::move(*root);
+		}
+
+		// Building blocks for encoders that do not go through Node
+
+		// Scalars are written as the native type their text maps to
+		static void EncodeScalar(const std::string& str, detail::ByteWriter& out)
+		{
+			EncodeNative(detail::NativeScalar::Classify(str), str, out);
+		}
+
+		// str is only written for STRING
+		static void EncodeNative(const detail::NativeScalar& native, std::string_view str, detail::ByteWriter& out)
+		{
+			switch (native.kind)
+			{
+			case detail::NativeScalar::BOOL:
+				out.Byte(native.b ? 0xc3 : 0xc2);
+				break;
+			case detail::NativeScalar::INT:
+				if (native.i >= -32)
+					out.Byte(static_cast<uint8_t>(native.i));
+				else if (native.i >= std::numeric_limits<int8_t>::min())
+					Header(out, 0xd0, static_cast<uint8_t>(native.i), 1);
+				else if (native.i >= std::numeric_limits<int16_t>::min())
+					Header(out, 0xd1, static_cast<uint16_t>(native.i), 2);
+				else if (native.i >= std::numeric_limits<int32_t>::min())
+					Header(out, 0xd2, static_cast<uint32_t>(native.i), 4);
+				else
+					Header(out, 0xd3, static_cast<uint64_t>(native.i), 8);
+				break;
+			case detail::NativeScalar::UINT:
+				if (native.u < 0x80)
+					out.Byte(static_cast<uint8_t>(native.u));
+				else
+					Length(out, native.u, 0, 0, 0xcc, 0xcd, 0xce, 0xcf);
+				break;
+			case detail::NativeScalar::DOUBLE:
+				out.Byte(0xcb);
+				out.Float64(native.d);
+				break;
+			default:
+				EncodeString(str, out);
+			}
+		}
+
+		static void EncodeString(std::string_view str, detail::ByteWriter& out)
+		{
+			Length(out, str.size(), 0xa0, 32, 0xd9, 0xda, 0xdb, 0);
+			out.Bytes(str);
+		}
+
+		static void EncodeArrayHeader(std::size_t size, detail::ByteWriter& out) { Length(out, size, 0x90, 16, 0, 0xdc, 0xdd, 0); }
+		static void EncodeMapHeader(std::size_t size, detail::ByteWriter& out) { Length(out, size, 0x80, 16, 0, 0xde, 0xdf, 0); }
+
+	private:
+		static void Encode(Node& node, detail::ByteWriter& out)
+		{
+			if (node.IsScalar())
+			{
+				auto native = node.ToNative();
+				EncodeNative(native, native.kind == detail::NativeScalar::STRING ? node.ToStringView() : std::string_view{}, out);
+			}
+			else if (node.IsList())
+			{
+				auto& list = static_cast<const Node&>(node).ToList();
+				EncodeArrayHeader(list.size(), out);
+				for (auto& curr : list)
+				{
+					if (!curr)
+						out.Byte(0xc0);
+					else
+						Encode(*curr, out);
+				}
+			}
+			else if (node.IsDict())
+			{
+				auto& dict = static_cast<const Node&>(node).ToDict();
+				EncodeMapHeader(detail::CountEntries(dict), out);
+				for (auto& curr : dict)
+				{
+					if (!curr.second || curr.second->IsNone())
+						continue;
+
+					EncodeString(curr.first, out);
+					Encode(*curr.second, out);
+				}
+			}
+			else
+				out.Byte(0xc0);
+		}
+
+		static void Header(detail::ByteWriter& out, uint8_t type, uint64_t val, std::size_t n)
+		{
+			out.Byte(type);
+			out.BigEndian(val, n);
+		}
+
+		// Picks the smallest of the fix/8/16/32/64 bit encodings, a zero marker
+		// means the encoding does not exist for the type
+		static void Length(detail::ByteWriter& out, uint64_t len, uint8_t fix, uint64_t fixMax, uint8_t m8, uint8_t m16, uint8_t m32, uint8_t m64)
+		{
+			if (fixMax > 0 && len < fixMax)
+				out.Byte(static_cast<uint8_t>(fix | len));
+			else if (m8 && len <= 0xFF)
+				Header(out, m8, len, 1);
+			else if (len <= 0xFFFF)
+				Header(out, m16, len, 2);
+			else if (len <= 0xFFFFFFFF)
+				Header(out, m32, len, 4);
+			else if (m64)
+				Header(out, m64, len, 8);
+			else
+				throw Error("Value too large for MessagePack");
+		}
+
+		static Node* Read(detail::ByteReader& in, std::size_t depth)
+		{
+			if (depth > detail::MAX_BINARY_DEPTH)
+				throw Error("Nesting too deep");
+
+			uint8_t type = in.Byte();
+
+			if (type <= 0x7f)
+				return new Node(static_cast<int64_t>(type));
+			if (type >= 0xe0)
+				return new Node(static_cast<int64_t>(static_cast<int8_t>(type)));
+			if ((type & 0xe0) == 0xa0)
+				return new Node(in.Bytes(type & 0x1f));
+			if ((type & 0xf0) == 0x90)
+				return ReadList(in, type & 0x0f, depth);
+			if ((type & 0xf0) == 0x80)
+				return ReadDict(in, type & 0x0f, depth);
+
+			switch (type)
+			{
+			case 0xc0:
+				return new Node();
+			case 0xc2:
+				return new Node(false);
+			case 0xc3:
+				return new Node(true);
+			case 0xc4:
+			case 0xd9:
+				return new Node(in.Bytes(in.BigEndian(1)));
+			case 0xc5:
+			case 0xda:
+				return new Node(in.Bytes(in.BigEndian(2)));
+			case 0xc6:
+			case 0xdb:
+				return new Node(in.Bytes(in.BigEndian(4)));
+			case 0xca:
+				return new Node(in.Float32());
+			case 0xcb:
+				return new Node(in.Float64());
+			case 0xcc:
+				return new Node(static_cast<int64_t>(in.BigEndian(1)));
+			case 0xcd:
+				return new Node(static_cast<int64_t>(in.BigEndian(2)));
+			case 0xce:
+				return new Node(static_cast<int64_t>(in.BigEndian(4)));
+			case 0xcf:
+				return detail::NewInteger(in.BigEndian(8));
+			case 0xd0:
+				return new Node(static_cast<int64_t>(static_cast<int8_t>(in.BigEndian(1))));
+			case 0xd1:
+				return new Node(static_cast<int64_t>(static_cast<int16_t>(in.BigEndian(2))));
+			case 0xd2:
+				return new Node(static_cast<int64_t>(static_cast<int32_t>(in.BigEndian(4))));
+			case 0xd3:
+				return new Node(static_cast<int64_t>(in.BigEndian(8)));
+			case 0xdc:
+				return ReadList(in, in.BigEndian(2), depth);
+			case 0xdd:
+				return ReadList(in, in.BigEndian(4), depth);
+			case 0xde:
+				return ReadDict(in, in.BigEndian(2), depth);
+			case 0xdf:
+				return ReadDict(in, in.BigEndian(4), depth);
+			}
+
+			throw Error("Unsupported MessagePack type");
+		}
+
+		static Node* ReadList(detail::ByteReader& in, uint64_t size, std::size_t depth)
+		{
+			detail::Children<Node::List> list;
+
+			for (uint64_t i = 0; i < size; i++)
+				list.val.push_back(Read(in, depth + 1));
+
+			return list.Release();
+		}
+
+		static Node* ReadDict(detail::ByteReader& in, uint64_t size, std::size_t depth)
+		{
+			detail::Children<Node::Dict> dict;
+
+			for (uint64_t i = 0; i < size; i++)
+			{
+				std::unique_ptr<Node> key{ Read(in, depth + 1) };
+				if (!key->IsScalar())
+					throw Error("MessagePack map keys have to be scalars");
+
+				std::unique_ptr<Node> value{ Read(in, depth + 1) };
+				if (dict.val.insert({ key->ToString(), value.get() }).second)
+					value.release();
+			}
+
+			return dict.Release();
+		}
+	};
+
+	class Cbor
+	{
+	public:
+		static void Encode(Node& node, std::ostream& os)
+		{
+			detail::ByteWriter out{ os };
+			Encode(node, out);
+		}
+
+		static Node Decode(std::istream& is)
+		{
+			detail::ByteReader in{ is };
+			std::unique_ptr<Node> root{ Read(in, 0) };
+			return std::move(*root);
+		}
+
+	private:
+		enum Major : uint8_t
+		{
+			UNSIGNED = 0,
+			NEGATIVE = 1,
+			BYTES = 2,
+			TEXT = 3,
+			ARRAY = 4,
+			MAP = 5,
+			TAG = 6,
+			SIMPLE = 7,
+		};
+
+		static constexpr uint8_t INDEFINITE = 31;
+		static constexpr uint8_t BREAK = 0xff;
+
+		static void Header(detail::ByteWriter& out, Major major, uint64_t val)
+		{
+			uint8_t type = static_cast<uint8_t>(major << 5);
+
+			if (val < 24)
+				out.Byte(type | static_cast<uint8_t>(val));
+			else if (val <= 0xFF)
+			{
+				out.Byte(type | 24);
+				out.BigEndian(val, 1);
+			}
+			else if (val <= 0xFFFF)
+			{
+				out.Byte(type | 25);
+				out.BigEndian(val, 2);
+			}
+			else if (val <= 0xFFFFFFFF)
+			{
+				out.Byte(type | 26);
+				out.BigEndian(val, 4);
+			}
+			else
+			{
+				out.Byte(type | 27);
+				out.BigEndian(val, 8);
+			}
+		}
+
+		static void Encode(Node& node, detail::ByteWriter& out)
+		{
+			if (node.IsScalar())
+			{
+				auto native = node.ToNative();
+
+				switch (native.kind)
+				{
+				case detail::NativeScalar::BOOL:
+					out.Byte(native.b ? 0xf5 : 0xf4);
+					break;
+				case detail::NativeScalar::INT:
+					Header(out, NEGATIVE, static_cast<uint64_t>(-(native.i + 1)));
+					break;
+				case detail::NativeScalar::UINT:
+					Header(out, UNSIGNED, native.u);
+					break;
+				case detail::NativeScalar::DOUBLE:
+					out.Byte(0xfb);
+					out.Float64(native.d);
+					break;
+				default:
+				{
+					auto str = node.ToStringView();
+					Header(out, TEXT, str.size());
+					out.Bytes(str);
+				}
+				}
+			}
+			else if (node.IsList())
+			{
+				auto& list = static_cast<const Node&>(node).ToList();
+				Header(out, ARRAY, list.size());
+				for (auto& curr : list)
+				{
+					if (!curr)
+						out.Byte(0xf6);
+					else
+						Encode(*curr, out);
+				}
+			}
+			else if (node.IsDict())
+			{
+				auto& dict = static_cast<const Node&>(node).ToDict();
+				Header(out, MAP, detail::CountEntries(dict));
+				for (auto& curr : dict)
+				{
+					if (!curr.second || curr.second->IsNone())
+						continue;
+
+					Header(out, TEXT, curr.first.size());
+					out.Bytes(curr.first);
+					Encode(*curr.second, out);
+				}
+			}
+			else
+				out.Byte(0xf6);
+		}
+
+		static uint64_t Argument(detail::ByteReader& in, uint8_t info)
+		{
+			if (info < 24)
+				return info;
+			if (info <= 27)
+				return in.BigEndian(std::size_t{ 1 } << (info - 24));
+
+			throw Error("Invalid CBOR argument");
+		}
+
+		static Node* Read(detail::ByteReader& in, std::size_t depth)
+		{
+			return Read(in, in.Byte(), depth);
+		}
+
+		static Node* Read(detail::ByteReader& in, uint8_t type, std::size_t depth)
+		{
+			if (depth > detail::MAX_BINARY_DEPTH)
+				throw Error("Nesting too deep");
+
+			Major major = static_cast<Major>(type >> 5);
+			uint8_t info = type & 0x1f;
+
+			switch (major)
+			{
+			case UNSIGNED:
+				return detail::NewInteger(Argument(in, info));
+			case NEGATIVE:
+			{
+				uint64_t val = Argument(in, info);
+				if (val > static_cast<uint64_t>(std::numeric_limits<int64_t>::max()))
+					return new Node(-1.0 - static_cast<double>(val));
+				return new Node(-1 - static_cast<int64_t>(val));
+			}
+			case BYTES:
+			case TEXT:
+			{
+				if (info != INDEFINITE)
+					return new Node(in.Bytes(Argument(in, info)));
+
+				// indefinite strings are a sequence of definite chunks
+				std::string str;
+				for (uint8_t chunk = in.Byte(); chunk != BREAK; chunk = in.Byte())
+				{
+					if ((chunk >> 5) != major || (chunk & 0x1f) == INDEFINITE)
+						throw Error("Invalid CBOR string chunk");
+					str += in.Bytes(Argument(in, chunk & 0x1f));
+				}
+				return new Node(str);
+			}
+			case ARRAY:
+			{
+				detail::Children<Node::List> list;
+
+				if (info == INDEFINITE)
+				{
+					for (uint8_t item = in.Byte(); item != BREAK; item = in.Byte())
+						list.val.push_back(Read(in, item, depth + 1));
+				}
+				else
+				{
+					uint64_t size = Argument(in, info);
+					for (uint64_t i = 0; i < size; i++)
+						list.val.push_back(Read(in, depth + 1));
+				}
+
+				return list.Release();
+			}
+			case MAP:
+			{
+				detail::Children<Node::Dict> dict;
+
+				auto entry = [&](uint8_t keyType) {
+					std::unique_ptr<Node> key{ Read(in, keyType, depth + 1) };
+					if (!key->IsScalar())
+						throw Error("CBOR map keys have to be scalars");
+
+					std::unique_ptr<Node> value{ Read(in, depth + 1) };
+					if (dict.val.insert({ key->ToString(), value.get() }).second)
+						value.release();
+				};
+
+				if (info == INDEFINITE)
+				{
+					for (uint8_t key = in.Byte(); key != BREAK; key = in.Byte())
+						entry(key);
+				}
+				else
+				{
+					uint64_t size = Argument(in, info);
+					for (uint64_t i = 0; i < size; i++)
+						entry(in.Byte());
+				}
+
+				return dict.Release();
+			}
+			case TAG:
+				// tags only annotate the following item
+				Argument(in, info);
+				return Read(in, depth + 1);
+			case SIMPLE:
+				switch (info)
+				{
+				case 20:
+					return new Node(false);
+				case 21:
+					return new Node(true);
+				case 22:
+				case 23:
+					return new Node();
+				case 25:
+					return new Node(HalfToDouble(static_cast<uint16_t>(in.BigEndian(2))));
+				case 26:
+					return new Node(in.Float32());
+				case 27:
+					return new Node(in.Float64());
+				}
+				break;
+			}
+
+			throw Error("Unsupported CBOR type");
+		}
+
+		static double HalfToDouble(uint16_t half)
+		{
+			int exp = (half >> 10) & 0x1f;
+			int mant = half & 0x3ff;
+			double val;
+
+			if (exp == 0)
+				val = std::ldexp(mant, -24);
+			else if (exp != 31)
+				val = std::ldexp(mant + 1024, exp - 25);
+			else
+				val = mant == 0 ? std::numeric_limits<double>::infinity() : std::numeric_limits<double>::quiet_NaN();
+
+			return half & 0x8000 ? -val : val;
+		}
+	};
+};
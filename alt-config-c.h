@@ -0,0 +1,307 @@
+#pragma once
+
+/*
+ * C interface for alt-config documents.
+ *
+ * Declarations can be included from C. Define ALT_CONFIG_C_IMPLEMENTATION in
+ * exactly one C++ translation unit before including this header to compile the
+ * implementation. No exceptions cross this boundary, failures are reported
+ * through return values and alt_config_error().
+ *
+ * Strings returned by the getters point into document storage and stay valid
+ * until the document is modified or freed.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef ALT_CONFIG_C_API
+#if defined(_WIN32) && defined(ALT_CONFIG_C_EXPORT)
+#define ALT_CONFIG_C_API __declspec(dllexport)
+#elif defined(__GNUC__)
+#define ALT_CONFIG_C_API __attribute__((visibility("default")))
+#else
+#define ALT_CONFIG_C_API
+#endif
+#endif
+
+#define ALT_CONFIG_C_VERSION 1
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+	typedef struct alt_config_doc alt_config_doc;
+	typedef struct alt_config_node alt_config_node;
+	typedef struct alt_config_iter alt_config_iter;
+
+	enum
+	{
+		ALT_CONFIG_NONE = 0,
+		ALT_CONFIG_SCALAR = 1,
+		ALT_CONFIG_LIST = 2,
+		ALT_CONFIG_DICT = 3,
+	};
+
+	enum
+	{
+		ALT_CONFIG_OK = 0,
+		ALT_CONFIG_ERROR = -1,
+		ALT_CONFIG_INVALID_CAST = -2,
+		ALT_CONFIG_END = -3,
+	};
+
+	ALT_CONFIG_C_API int32_t alt_config_version(void);
+
+	/* Message of the last failed call on this thread */
+	ALT_CONFIG_C_API const char* alt_config_error(void);
+
+	ALT_CONFIG_C_API int32_t alt_config_parse(const char* data, size_t size, alt_config_doc** doc);
+	ALT_CONFIG_C_API void alt_config_free(alt_config_doc* doc);
+
+	/* Makes the document read only, lookups no longer modify it */
+	ALT_CONFIG_C_API void alt_config_freeze(alt_config_doc* doc);
+	/* Frozen deep copy, e.g. to hand to another thread */
+	ALT_CONFIG_C_API int32_t alt_config_snapshot(alt_config_doc* doc, alt_config_doc** snapshot);
+
+	ALT_CONFIG_C_API alt_config_node* alt_config_root(alt_config_doc* doc);
+	ALT_CONFIG_C_API int32_t alt_config_type(alt_config_node* node);
+
+	ALT_CONFIG_C_API int32_t alt_config_scalar(alt_config_node* node, const char** data, size_t* size);
+	ALT_CONFIG_C_API int32_t alt_config_bool(alt_config_node* node, int32_t* value);
+	ALT_CONFIG_C_API int32_t alt_config_number(alt_config_node* node, double* value);
+
+	/*
+	 * Empty dict entries, which C++ lookups through operator[] leave behind, are
+	 * treated as missing by the functions below.
+	 */
+
+	/* Number of list items or dict entries, 0 for scalars */
+	ALT_CONFIG_C_API size_t alt_config_size(alt_config_node* node);
+	/* NULL if out of range or not a list */
+	ALT_CONFIG_C_API alt_config_node* alt_config_at(alt_config_node* node, size_t index);
+	/* NULL if missing or not a dict */
+	ALT_CONFIG_C_API alt_config_node* alt_config_get(alt_config_node* node, const char* key, size_t keySize);
+
+	/* Dict iteration, alt_config_next returns ALT_CONFIG_END after the last entry */
+	ALT_CONFIG_C_API alt_config_iter* alt_config_iterate(alt_config_node* node);
+	ALT_CONFIG_C_API int32_t alt_config_next(alt_config_iter* iter, const char** key, size_t* keySize, alt_config_node** value);
+	ALT_CONFIG_C_API void alt_config_iter_free(alt_config_iter* iter);
+
+#ifdef __cplusplus
+}
+#endif
+
+#ifdef ALT_CONFIG_C_IMPLEMENTATION
+
+#include "alt-config.h"
+
+struct alt_config_doc
+{
+	alt::config::Node root;
+};
+
+struct alt_config_iter
+{
+	alt::config::Node::Dict::const_iterator it;
+	alt::config::Node::Dict::const_iterator end;
+};
+
+namespace alt::config::detail
+{
+	inline std::string& CError()
+	{
+		thread_local std::string error;
+		return error;
+	}
+
+	inline Node* CNode(alt_config_node* node) { return reinterpret_cast<Node*>(node); }
+	inline alt_config_node* CHandle(Node* node) { return reinterpret_cast<alt_config_node*>(node); }
+
+	// Runs func, library errors are reported as errorCode
+	template<class Func>
+	int32_t CCall(Func&& func, int32_t errorCode = ALT_CONFIG_ERROR)
+	{
+		try
+		{
+			return func();
+		}
+		catch (const Error& e)
+		{
+			CError() = e.what();
+			if (e.line() > 0)
+				CError() += " (line " + std::to_string(e.line()) + ", column " + std::to_string(e.column()) + ")";
+
+			return errorCode;
+		}
+		catch (const std::exception& e)
+		{
+			CError() = e.what();
+			return ALT_CONFIG_ERROR;
+		}
+		catch (...)
+		{
+			CError() = "Unknown error";
+			return ALT_CONFIG_ERROR;
+		}
+	}
+}
+
+extern "C"
+{
+	int32_t alt_config_version(void) { return ALT_CONFIG_C_VERSION; }
+
+	const char* alt_config_error(void) { return alt::config::detail::CError().c_str(); }
+
+	int32_t alt_config_parse(const char* data, size_t size, alt_config_doc** doc)
+	{
+		*doc = nullptr;
+		return alt::config::detail::CCall([&]() {
+			alt::config::Parser parser{ data, size };
+			*doc = new alt_config_doc{ parser.Parse() };
+			return ALT_CONFIG_OK;
+		});
+	}
+
+	void alt_config_free(alt_config_doc* doc) { delete doc; }
+
+	void alt_config_freeze(alt_config_doc* doc)
+	{
+		alt::config::detail::CCall([&]() {
+			doc->root.Freeze();
+			return ALT_CONFIG_OK;
+		});
+	}
+
+	int32_t alt_config_snapshot(alt_config_doc* doc, alt_config_doc** snapshot)
+	{
+		*snapshot = nullptr;
+		return alt::config::detail::CCall([&]() {
+			auto copy = new alt_config_doc{ doc->root };
+			copy->root.Freeze();
+			*snapshot = copy;
+			return ALT_CONFIG_OK;
+		});
+	}
+
+	alt_config_node* alt_config_root(alt_config_doc* doc) { return alt::config::detail::CHandle(&doc->root); }
+
+	int32_t alt_config_type(alt_config_node* node)
+	{
+		if (!node)
+			return ALT_CONFIG_NONE;
+		return static_cast<int32_t>(alt::config::detail::CNode(node)->GetType());
+	}
+
+	int32_t alt_config_scalar(alt_config_node* node, const char** data, size_t* size)
+	{
+		if (!node)
+			return ALT_CONFIG_INVALID_CAST;
+
+		return alt::config::detail::CCall([&]() {
+			auto view = alt::config::detail::CNode(node)->ToStringView();
+			*data = view.data();
+			*size = view.size();
+			return ALT_CONFIG_OK;
+		}, ALT_CONFIG_INVALID_CAST);
+	}
+
+	int32_t alt_config_bool(alt_config_node* node, int32_t* value)
+	{
+		if (!node)
+			return ALT_CONFIG_INVALID_CAST;
+
+		return alt::config::detail::CCall([&]() {
+			*value = alt::config::detail::CNode(node)->ToBool() ? 1 : 0;
+			return ALT_CONFIG_OK;
+		}, ALT_CONFIG_INVALID_CAST);
+	}
+
+	int32_t alt_config_number(alt_config_node* node, double* value)
+	{
+		if (!node)
+			return ALT_CONFIG_INVALID_CAST;
+
+		return alt::config::detail::CCall([&]() {
+			*value = alt::config::detail::CNode(node)->ToNumber();
+			return ALT_CONFIG_OK;
+		}, ALT_CONFIG_INVALID_CAST);
+	}
+
+	size_t alt_config_size(alt_config_node* node)
+	{
+		auto n = alt::config::detail::CNode(node);
+		if (!n)
+			return 0;
+		if (n->IsList())
+			return static_cast<const alt::config::Node*>(n)->ToList().size();
+		if (n->IsDict())
+		{
+			auto& dict = static_cast<const alt::config::Node*>(n)->ToDict();
+			return static_cast<size_t>(std::count_if(dict.begin(), dict.end(), [](auto& curr) { return !curr.second->IsNone(); }));
+		}
+		return 0;
+	}
+
+	alt_config_node* alt_config_at(alt_config_node* node, size_t index)
+	{
+		auto n = alt::config::detail::CNode(node);
+		if (!n || !n->IsList())
+			return nullptr;
+
+		auto& list = static_cast<const alt::config::Node*>(n)->ToList();
+		return index < list.size() ? alt::config::detail::CHandle(list[index]) : nullptr;
+	}
+
+	alt_config_node* alt_config_get(alt_config_node* node, const char* key, size_t keySize)
+	{
+		alt::config::Node* result = nullptr;
+		if (!node)
+			return nullptr;
+
+		alt::config::detail::CCall([&]() {
+			result = alt::config::detail::CNode(node)->Find(alt::config::Key{ key, keySize });
+			if (result && result->IsNone())
+				result = nullptr;
+			return ALT_CONFIG_OK;
+		});
+		return alt::config::detail::CHandle(result);
+	}
+
+	alt_config_iter* alt_config_iterate(alt_config_node* node)
+	{
+		auto n = alt::config::detail::CNode(node);
+		if (!n || !n->IsDict())
+			return nullptr;
+
+		alt_config_iter* iter = nullptr;
+		alt::config::detail::CCall([&]() {
+			auto& dict = static_cast<const alt::config::Node*>(n)->ToDict();
+			iter = new alt_config_iter{ dict.begin(), dict.end() };
+			return ALT_CONFIG_OK;
+		});
+		return iter;
+	}
+
+	int32_t alt_config_next(alt_config_iter* iter, const char** key, size_t* keySize, alt_config_node** value)
+	{
+		if (!iter)
+			return ALT_CONFIG_END;
+
+		while (iter->it != iter->end && iter->it->second->IsNone())
+			++iter->it;
+		if (iter->it == iter->end)
+			return ALT_CONFIG_END;
+
+		*key = iter->it->first.data();
+		*keySize = iter->it->first.size();
+		*value = alt::config::detail::CHandle(iter->it->second);
+		++iter->it;
+		return ALT_CONFIG_OK;
+	}
+
+	void alt_config_iter_free(alt_config_iter* iter) { delete iter; }
+}
+
+#endif
@@ -0,0 +1,148 @@
+#pragma once
+
+#include "alt-config.h"
+
+#include <optional>
+
+namespace alt::config
+{
+	// Values computed from parts of a document, e.g. a lookup grid built from
+	// a list. Every computation records the paths it reads, Update() after a
+	// mutation or reload only invalidates the derivations whose inputs changed
+	// and those are recomputed on their next Get(). Inputs are compared by
+	// Node::Fingerprint(), so writes through references or containers taken
+	// before are seen as well. Not synchronized.
+	class DerivedRegistry
+	{
+	public:
+		// Handed to the computation, reads through it are tracked
+		class Inputs
+		{
+		public:
+			// Node at the dotted path, nullptr if missing
+			Node* Get(const std::string& path)
+			{
+				paths.push_back(path);
+
+				Node* node = root.GetMany({ path })[0];
+				return node && !node->IsNone() ? node : nullptr;
+			}
+
+		private:
+			friend class DerivedRegistry;
+
+			Inputs(Node& _root) : root(_root) { }
+
+			Node& root;
+			std::vector<std::string> paths;
+		};
+
+		static DerivedRegistry& Global()
+		{
+			static DerivedRegistry registry;
+			return registry;
+		}
+
+		DerivedRegistry() = default;
+		DerivedRegistry(const DerivedRegistry&) = delete;
+		DerivedRegistry& operator=(const DerivedRegistry&) = delete;
+
+		// Compares the inputs of every derivation against root, which is used
+		// for computing until the next Update and has to stay alive until then
+		void Update(Node& _root)
+		{
+			root = &_root;
+
+			for (auto entry : entries)
+			{
+				if (!entry->stale && Fingerprints(entry->paths) != entry->fingerprints)
+					entry->stale = true;
+			}
+		}
+
+	private:
+		template<class T>
+		friend class Derived;
+
+		struct Entry
+		{
+			bool stale = true;
+			std::vector<std::string> paths;
+			std::vector<uint64_t> fingerprints;
+		};
+
+		void Register(Entry* entry) { entries.push_back(entry); }
+		void Unregister(Entry* entry) { entries.erase(std::find(entries.begin(), entries.end(), entry)); }
+
+		template<class Func>
+		void Compute(Entry& entry, Func&& func)
+		{
+			if (!root)
+				throw Error("No document, call Update first");
+
+			Inputs inputs{ *root };
+			func(inputs);
+
+			auto& paths = inputs.paths;
+			std::sort(paths.begin(), paths.end());
+			paths.erase(std::unique(paths.begin(), paths.end()), paths.end());
+
+			entry.fingerprints = Fingerprints(paths);
+			entry.paths = std::move(paths);
+			entry.stale = false;
+		}
+
+		// missing paths are 0
+		std::vector<uint64_t> Fingerprints(const std::vector<std::string>& paths)
+		{
+			std::vector<uint64_t> result;
+			result.reserve(paths.size());
+
+			for (Node* node : root->GetMany(paths))
+				result.push_back(node && !node->IsNone() ? node->Fingerprint() : 0);
+
+			return result;
+		}
+
+		std::vector<Entry*> entries;
+		Node* root = nullptr;
+	};
+
+	template<class T>
+	class Derived
+	{
+	public:
+		using Compute = std::function<T(DerivedRegistry::Inputs& inputs)>;
+
+		Derived(Compute _compute, DerivedRegistry& _registry = DerivedRegistry::Global()) :
+			compute(std::move(_compute)),
+			registry(_registry)
+		{
+			registry.Register(&entry);
+		}
+
+		Derived(const Derived&) = delete;
+		Derived& operator=(const Derived&) = delete;
+
+		~Derived() { registry.Unregister(&entry); }
+
+		// Recomputes the value if it was never computed or an input changed
+		const T& Get()
+		{
+			if (entry.stale)
+				registry.Compute(entry, [this](DerivedRegistry::Inputs& inputs) { value = compute(inputs); });
+
+			return *value;
+		}
+
+		operator const T&() { return Get(); }
+
+		bool IsStale() const { return entry.stale; }
+
+	private:
+		Compute compute;
+		DerivedRegistry& registry;
+		DerivedRegistry::Entry entry;
+		std::optional<T> value;
+	};
+};
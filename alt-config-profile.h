@@ -0,0 +1,192 @@
+#pragma once
+
+#include "alt-config.h"
+
+#include <chrono>
+#include <cstring>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace alt::config
+{
+	// Measures parsing, tokenizing and emitting with hardware counters where
+	// the kernel allows it (Linux perf_event_open, see perf_event_paranoid).
+	// Counters that can not be opened stay zero, the wall time is always
+	// measured. Only the calling thread is counted.
+	class Profiler
+	{
+	public:
+		struct Report
+		{
+			// input bytes, output bytes for Emit
+			std::size_t bytes = 0;
+			uint64_t nanoseconds = 0;
+
+			// zero if not available
+			uint64_t cycles = 0;
+			uint64_t instructions = 0;
+			uint64_t branchMisses = 0;
+			uint64_t cacheMisses = 0;
+
+			double PerByte(uint64_t count) const { return bytes ? static_cast<double>(count) / bytes : 0; }
+
+			friend std::ostream& operator<<(std::ostream& os, const Report& report)
+			{
+				os << report.bytes << " bytes, " << report.PerByte(report.nanoseconds) << " ns/byte";
+				if (report.cycles) os << ", " << report.PerByte(report.cycles) << " cycles/byte";
+				if (report.instructions) os << ", " << report.PerByte(report.instructions) << " instructions/byte";
+				if (report.branchMisses) os << ", " << report.PerByte(report.branchMisses) << " branch misses/byte";
+				if (report.cacheMisses) os << ", " << report.PerByte(report.cacheMisses) << " cache misses/byte";
+				return os;
+			}
+		};
+
+		Profiler()
+		{
+#ifdef __linux__
+			fds[CYCLES] = Open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+			fds[INSTRUCTIONS] = Open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+			fds[BRANCH_MISSES] = Open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES);
+			fds[CACHE_MISSES] = Open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+#endif
+		}
+
+		~Profiler()
+		{
+#ifdef __linux__
+			for (int fd : fds)
+			{
+				if (fd >= 0) close(fd);
+			}
+#endif
+		}
+
+		Profiler(const Profiler&) = delete;
+		Profiler& operator=(const Profiler&) = delete;
+
+		// Whether any hardware counter could be opened
+		bool HasCounters() const
+		{
+			for (int fd : fds)
+			{
+				if (fd >= 0) return true;
+			}
+			return false;
+		}
+
+		// Runs func, bytes is what the report is normalized to
+		template<class Func>
+		Report Measure(std::size_t bytes, Func&& func)
+		{
+			Report report;
+			report.bytes = bytes;
+
+			Start();
+			auto begin = std::chrono::steady_clock::now();
+			func();
+			auto end = std::chrono::steady_clock::now();
+			Stop(report);
+
+			report.nanoseconds = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count());
+			return report;
+		}
+
+		// size is the input size the parser was constructed with
+		Node Parse(Parser& parser, std::size_t size, Report& report)
+		{
+			Node result;
+			report = Measure(size, [&]() { result = parser.Parse(); });
+			return result;
+		}
+
+		const std::vector<Lexer::Token>& Lex(Lexer& lexer, std::size_t size, Report& report)
+		{
+			const std::vector<Lexer::Token>* result = nullptr;
+			report = Measure(size, [&]() { result = &lexer.Lex(); });
+			return *result;
+		}
+
+		// Emits into memory first so the stream is not measured, the report is
+		// per output byte
+		void Emit(Node& node, std::ostream& os, Report& report)
+		{
+			std::ostringstream out;
+			report = Measure(0, [&]() { Emitter::Emit(node, out); });
+
+			std::string text = out.str();
+			report.bytes = text.size();
+			os << text;
+		}
+
+	private:
+		enum Counter
+		{
+			CYCLES,
+			INSTRUCTIONS,
+			BRANCH_MISSES,
+			CACHE_MISSES,
+			COUNT
+		};
+
+		int fds[COUNT] = { -1, -1, -1, -1 };
+
+#ifdef __linux__
+		static int Open(uint32_t type, uint64_t config)
+		{
+			perf_event_attr attr;
+			std::memset(&attr, 0, sizeof(attr));
+			attr.size = sizeof(attr);
+			attr.type = type;
+			attr.config = config;
+			attr.disabled = 1;
+			// allowed with the default perf_event_paranoid
+			attr.exclude_kernel = 1;
+			attr.exclude_hv = 1;
+
+			return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+		}
+#endif
+
+		void Start()
+		{
+#ifdef __linux__
+			for (int fd : fds)
+			{
+				if (fd < 0) continue;
+				ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+				ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+			}
+#endif
+		}
+
+		void Stop(Report& report)
+		{
+#ifdef __linux__
+			for (int fd : fds)
+			{
+				if (fd >= 0) ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+			}
+
+			report.cycles = Read(fds[CYCLES]);
+			report.instructions = Read(fds[INSTRUCTIONS]);
+			report.branchMisses = Read(fds[BRANCH_MISSES]);
+			report.cacheMisses = Read(fds[CACHE_MISSES]);
+#endif
+		}
+
+#ifdef __linux__
+		static uint64_t Read(int fd)
+		{
+			uint64_t count = 0;
+			if (fd < 0 || read(fd, &count, sizeof(count)) != sizeof(count))
+				return 0;
+			return count;
+		}
+#endif
+	};
+};
@@ -0,0 +1,116 @@
+#pragma once
+
+#include "alt-config.h"
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+namespace alt::config
+{
+	// Destroys retired trees on a background thread so dropping a large
+	// document never stalls the caller. The thread is started on first use.
+	class Reclaimer
+	{
+	public:
+		// shared_ptr deleter that hands the tree to the global reclaimer:
+		// std::shared_ptr<Node>(new Node(parser.Parse()), Reclaimer::Deleter{})
+		struct Deleter
+		{
+			void operator()(Node* node) const { Global().Retire(std::unique_ptr<Node>(node)); }
+		};
+
+		static Reclaimer& Global()
+		{
+			static Reclaimer reclaimer;
+			return reclaimer;
+		}
+
+		Reclaimer() = default;
+		Reclaimer(const Reclaimer&) = delete;
+		Reclaimer& operator=(const Reclaimer&) = delete;
+
+		~Reclaimer()
+		{
+			{
+				std::lock_guard<std::mutex> lock{ mutex };
+				stop = true;
+			}
+			cv.notify_all();
+
+			if (worker.joinable())
+				worker.join();
+		}
+
+		// Takes over the tree, node is left empty
+		void Retire(Node&& node) { Retire(std::unique_ptr<Node>(new Node(std::move(node)))); }
+
+		void Retire(std::unique_ptr<Node> node)
+		{
+			if (node)
+				Push(std::shared_ptr<Node>(std::move(node)));
+		}
+
+		// Drops the reference in the background, the tree is destroyed there if
+		// it was the last one
+		void Retire(std::shared_ptr<Node> node)
+		{
+			if (node)
+				Push(std::move(node));
+		}
+
+		// Blocks until everything retired so far is destroyed
+		void Flush()
+		{
+			std::unique_lock<std::mutex> lock{ mutex };
+			std::size_t target = retired;
+			done.wait(lock, [&]() { return destroyed >= target; });
+		}
+
+	private:
+		void Push(std::shared_ptr<Node> node)
+		{
+			{
+				std::lock_guard<std::mutex> lock{ mutex };
+				if (!worker.joinable())
+					worker = std::thread(&Reclaimer::Run, this);
+
+				queue.push_back(std::move(node));
+				retired++;
+			}
+			cv.notify_one();
+		}
+
+		void Run()
+		{
+			std::vector<std::shared_ptr<Node>> batch;
+			std::unique_lock<std::mutex> lock{ mutex };
+
+			while (true)
+			{
+				cv.wait(lock, [this]() { return stop || !queue.empty(); });
+				if (queue.empty())
+					break;
+
+				batch.swap(queue);
+				lock.unlock();
+
+				std::size_t count = batch.size();
+				batch.clear();
+
+				lock.lock();
+				destroyed += count;
+				done.notify_all();
+			}
+		}
+
+		std::mutex mutex;
+		std::condition_variable cv;
+		std::condition_variable done;
+		std::vector<std::shared_ptr<Node>> queue;
+		std::size_t retired = 0;
+		std::size_t destroyed = 0;
+		bool stop = false;
+		std::thread worker;
+	};
+};
@@ -0,0 +1,258 @@
+#pragma once
+
+#include "alt-config-binary.h"
+
+#include <map>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+// Declares the fields Serializer writes for a struct, in declaration order.
+// Has to be used in the namespace of the struct:
+//   struct Vehicle { std::string model; double mass; std::vector<Wheel> wheels; };
+//   ALT_CONFIG_FIELDS(Vehicle, model, mass, wheels)
+#define ALT_CONFIG_FIELDS(Type, ...) \
+	inline auto AltConfigFields(const Type*) \
+	{ \
+		return std::make_tuple(ALT_CONFIG_FOR_EACH(ALT_CONFIG_FIELD, Type, __VA_ARGS__)); \
+	}
+
+#define ALT_CONFIG_FIELD(Type, name) ::alt::config::detail::MakeField(#name, &Type::name)
+
+// up to 32 fields, ALT_CONFIG_EXPAND is needed for the MSVC preprocessor
+#define ALT_CONFIG_EXPAND(x) x
+#define ALT_CONFIG_FE_1(m, t, x) m(t, x)
+#define ALT_CONFIG_FE_2(m, t, x, ...) m(t, x), ALT_CONFIG_EXPAND(ALT_CONFIG_FE_1(m, t, __VA_ARGS__))
+#define ALT_CONFIG_FE_3(m, t, x, ...) m(t, x), ALT_CONFIG_EXPAND(ALT_CONFIG_FE_2(m, t, __VA_ARGS__))
+#define ALT_CONFIG_FE_4(m, t, x, ...) m(t, x), ALT_CONFIG_EXPAND(ALT_CONFIG_FE_3(m, t, __VA_ARGS__))
+#define ALT_CONFIG_FE_5(m, t, x, ...) m(t, x), ALT_CONFIG_EXPAND(ALT_CONFIG_FE_4(m, t, __VA_ARGS__))
+#define ALT_CONFIG_FE_6(m, t, x, ...) m(t, x), ALT_CONFIG_EXPAND(ALT_CONFIG_FE_5(m, t, __VA_ARGS__))
+#define ALT_CONFIG_FE_7(m, t, x, ...) m(t, x), ALT_CONFIG_EXPAND(ALT_CONFIG_FE_6(m, t, __VA_ARGS__))
+#define ALT_CONFIG_FE_8(m, t, x, ...) m(t, x), ALT_CONFIG_EXPAND(ALT_CONFIG_FE_7(m, t, __VA_ARGS__))
+#define ALT_CONFIG_FE_9(m, t, x, ...) m(t, x), ALT_CONFIG_EXPAND(ALT_CONFIG_FE_8(m, t, __VA_ARGS__))
+#define ALT_CONFIG_FE_10(m, t, x, ...) m(t, x), ALT_CONFIG_EXPAND(ALT_CONFIG_FE_9(m, t, __VA_ARGS__))
+#define ALT_CONFIG_FE_11(m, t, x, ...) m(t, x), ALT_CONFIG_EXPAND(ALT_CONFIG_FE_10(m, t, __VA_ARGS__))
+#define ALT_CONFIG_FE_12(m, t, x, ...) m(t, x), ALT_CONFIG_EXPAND(ALT_CONFIG_FE_11(m, t, __VA_ARGS__))
+#define ALT_CONFIG_FE_13(m, t, x, ...) m(t, x), ALT_CONFIG_EXPAND(ALT_CONFIG_FE_12(m, t, __VA_ARGS__))
+#define ALT_CONFIG_FE_14(m, t, x, ...) m(t, x), ALT_CONFIG_EXPAND(ALT_CONFIG_FE_13(m, t, __VA_ARGS__))
+#define ALT_CONFIG_FE_15(m, t, x, ...) m(t, x), ALT_CONFIG_EXPAND(ALT_CONFIG_FE_14(m, t, __VA_ARGS__))
+#define ALT_CONFIG_FE_16(m, t, x, ...) m(t, x), ALT_CONFIG_EXPAND(ALT_CONFIG_FE_15(m, t, __VA_ARGS__))
+#define ALT_CONFIG_FE_17(m, t, x, ...) m(t, x), ALT_CONFIG_EXPAND(ALT_CONFIG_FE_16(m, t, __VA_ARGS__))
+#define ALT_CONFIG_FE_18(m, t, x, ...) m(t, x), ALT_CONFIG_EXPAND(ALT_CONFIG_FE_17(m, t, __VA_ARGS__))
+#define ALT_CONFIG_FE_19(m, t, x, ...) m(t, x), ALT_CONFIG_EXPAND(ALT_CONFIG_FE_18(m, t, __VA_ARGS__))
+#define ALT_CONFIG_FE_20(m, t, x, ...) m(t, x), ALT_CONFIG_EXPAND(ALT_CONFIG_FE_19(m, t, __VA_ARGS__))
+#define ALT_CONFIG_FE_21(m, t, x, ...) m(t, x), ALT_CONFIG_EXPAND(ALT_CONFIG_FE_20(m, t, __VA_ARGS__))
+#define ALT_CONFIG_FE_22(m, t, x, ...) m(t, x), ALT_CONFIG_EXPAND(ALT_CONFIG_FE_21(m, t, __VA_ARGS__))
+#define ALT_CONFIG_FE_23(m, t, x, ...) m(t, x), ALT_CONFIG_EXPAND(ALT_CONFIG_FE_22(m, t, __VA_ARGS__))
+#define ALT_CONFIG_FE_24(m, t, x, ...) m(t, x), ALT_CONFIG_EXPAND(ALT_CONFIG_FE_23(m, t, __VA_ARGS__))
+#define ALT_CONFIG_FE_25(m, t, x, ...) m(t, x), ALT_CONFIG_EXPAND(ALT_CONFIG_FE_24(m, t, __VA_ARGS__))
+#define ALT_CONFIG_FE_26(m, t, x, ...) m(t, x), ALT_CONFIG_EXPAND(ALT_CONFIG_FE_25(m, t, __VA_ARGS__))
+#define ALT_CONFIG_FE_27(m, t, x, ...) m(t, x), ALT_CONFIG_EXPAND(ALT_CONFIG_FE_26(m, t, __VA_ARGS__))
+#define ALT_CONFIG_FE_28(m, t, x, ...) m(t, x), ALT_CONFIG_EXPAND(ALT_CONFIG_FE_27(m, t, __VA_ARGS__))
+#define ALT_CONFIG_FE_29(m, t, x, ...) m(t, x), ALT_CONFIG_EXPAND(ALT_CONFIG_FE_28(m, t, __VA_ARGS__))
+#define ALT_CONFIG_FE_30(m, t, x, ...) m(t, x), ALT_CONFIG_EXPAND(ALT_CONFIG_FE_29(m, t, __VA_ARGS__))
+#define ALT_CONFIG_FE_31(m, t, x, ...) m(t, x), ALT_CONFIG_EXPAND(ALT_CONFIG_FE_30(m, t, __VA_ARGS__))
+#define ALT_CONFIG_FE_32(m, t, x, ...) m(t, x), ALT_CONFIG_EXPAND(ALT_CONFIG_FE_31(m, t, __VA_ARGS__))
+#define ALT_CONFIG_FE_PICK(_1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12, _13, _14, _15, _16, _17, _18, _19, _20, _21, _22, _23, _24, _25, _26, _27, _28, _29, _30, _31, _32, N, ...) N
+#define ALT_CONFIG_FOR_EACH(m, t, ...) ALT_CONFIG_EXPAND(ALT_CONFIG_FE_PICK(__VA_ARGS__, ALT_CONFIG_FE_32, ALT_CONFIG_FE_31, ALT_CONFIG_FE_30, ALT_CONFIG_FE_29, ALT_CONFIG_FE_28, ALT_CONFIG_FE_27, ALT_CONFIG_FE_26, ALT_CONFIG_FE_25, ALT_CONFIG_FE_24, ALT_CONFIG_FE_23, ALT_CONFIG_FE_22, ALT_CONFIG_FE_21, ALT_CONFIG_FE_20, ALT_CONFIG_FE_19, ALT_CONFIG_FE_18, ALT_CONFIG_FE_17, ALT_CONFIG_FE_16, ALT_CONFIG_FE_15, ALT_CONFIG_FE_14, ALT_CONFIG_FE_13, ALT_CONFIG_FE_12, ALT_CONFIG_FE_11, ALT_CONFIG_FE_10, ALT_CONFIG_FE_9, ALT_CONFIG_FE_8, ALT_CONFIG_FE_7, ALT_CONFIG_FE_6, ALT_CONFIG_FE_5, ALT_CONFIG_FE_4, ALT_CONFIG_FE_3, ALT_CONFIG_FE_2, ALT_CONFIG_FE_1)(m, t, __VA_ARGS__))
+
+namespace alt::config
+{
+	namespace detail
+	{
+		template<class Class, class Member>
+		struct Field
+		{
+			const char* name;
+			Member Class::* ptr;
+		};
+
+		template<class Class, class Member>
+		constexpr Field<Class, Member> MakeField(const char* name, Member Class::* ptr) { return { name, ptr }; }
+
+		template<class T, class = void>
+		struct HasFields : std::false_type { };
+		template<class T>
+		struct HasFields<T, std::void_t<decltype(AltConfigFields(static_cast<const T*>(nullptr)))>> : std::true_type { };
+
+		template<class T>
+		struct IsSequence : std::false_type { };
+		template<class T, class A>
+		struct IsSequence<std::vector<T, A>> : std::true_type { };
+		template<class T, class A>
+		struct IsSequence<std::deque<T, A>> : std::true_type { };
+
+		template<class T>
+		struct IsMap : std::false_type { };
+		template<class T, class C, class A>
+		struct IsMap<std::map<std::string, T, C, A>> : std::true_type { };
+		template<class T, class H, class E, class A>
+		struct IsMap<std::unordered_map<std::string, T, H, E, A>> : std::true_type { };
+
+		// Same text the Node constructors would produce
+		template<class T>
+		std::string FormatScalar(const T& val)
+		{
+			if constexpr (std::is_same_v<T, bool>)
+				return val ? "true" : "false";
+			else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>)
+				return std::to_string(static_cast<int64_t>(val));
+			else if constexpr (std::is_integral_v<T>)
+			{
+				// Node(uint64_t) keeps values beyond int64 as double
+				if (static_cast<uint64_t>(val) > static_cast<uint64_t>(std::numeric_limits<int64_t>::max()))
+					return FormatNumber(static_cast<double>(val));
+				return std::to_string(static_cast<uint64_t>(val));
+			}
+			else if constexpr (std::is_arithmetic_v<T>)
+				return FormatNumber(static_cast<double>(val));
+			else
+				return std::string{ val };
+		}
+
+		// Same native value Node::ToNative() gives for the Node built from val
+		template<class T>
+		NativeScalar ToNative(const T& val)
+		{
+			if constexpr (std::is_same_v<T, bool>)
+				return NativeScalar::FromBool(val);
+			else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>)
+				return NativeScalar::FromInt(static_cast<int64_t>(val));
+			else if constexpr (std::is_integral_v<T>)
+			{
+				if (static_cast<uint64_t>(val) > static_cast<uint64_t>(std::numeric_limits<int64_t>::max()))
+					return NativeScalar::FromDouble(static_cast<double>(val));
+				return NativeScalar::FromUInt(static_cast<uint64_t>(val));
+			}
+			else
+				return NativeScalar::FromDouble(static_cast<double>(val));
+		}
+	}
+
+	// Writes structs declared with ALT_CONFIG_FIELDS, maps with string keys,
+	// vectors and scalars without building a Node tree first. Text output uses
+	// the layout, quoting and escaping of Emitter::Emit, struct fields are
+	// written in declaration order.
+	class Serializer
+	{
+	public:
+		template<class T>
+		static void Emit(const T& obj, std::ostream& os)
+		{
+			static_assert(detail::HasFields<T>::value || detail::IsMap<T>::value, "The document root has to be a struct or a map");
+			Emit(obj, os, 0, true);
+		}
+
+		template<class T>
+		static void EncodeMsgPack(const T& obj, std::ostream& os)
+		{
+			detail::ByteWriter out{ os };
+			Encode(obj, out);
+		}
+
+	private:
+		template<class T>
+		static void Emit(const T& val, std::ostream& os, int indent, bool isLast)
+		{
+			std::string _indent(indent * 2, ' ');
+
+			if constexpr (detail::HasFields<T>::value)
+			{
+				if (indent > 0)
+					os << "{\n";
+
+				std::apply([&](const auto&... field) {
+					std::size_t i = 0;
+					constexpr std::size_t count = sizeof...(field);
+					((os << _indent << field.name << ": ", Emit(val.*field.ptr, os, indent + 1, ++i == count)), ...);
+				}, AltConfigFields(static_cast<const T*>(nullptr)));
+
+				if (indent > 0)
+					os << std::string((indent - 1) * 2, ' ') << (isLast ? "}\n" : "},\n");
+			}
+			else if constexpr (detail::IsMap<T>::value)
+			{
+				if (indent > 0)
+					os << "{\n";
+
+				std::size_t i = 0;
+				for (auto& curr : val)
+				{
+					os << _indent << curr.first << ": ";
+					Emit(curr.second, os, indent + 1, ++i == val.size());
+				}
+
+				if (indent > 0)
+					os << std::string((indent - 1) * 2, ' ') << (isLast ? "}\n" : "},\n");
+			}
+			else if constexpr (detail::IsSequence<T>::value)
+			{
+				os << "[\n";
+
+				std::size_t i = 0;
+				for (auto& curr : val)
+				{
+					os << _indent;
+					Emit(curr, os, indent + 1, ++i == val.size());
+				}
+
+				os << std::string((indent - 1) * 2, ' ') << (isLast ? "]\n" : "],\n");
+			}
+			else
+			{
+				static_assert(std::is_arithmetic_v<T> || std::is_convertible_v<const T&, std::string_view>, "Unsupported field type");
+
+				if constexpr (std::is_same_v<T, std::string>)
+					os << '\'' << detail::Escape(val) << "'\n";
+				else
+					os << '\'' << detail::Escape(detail::FormatScalar(val)) << "'\n";
+			}
+		}
+
+		template<class T>
+		static void Encode(const T& val, detail::ByteWriter& out)
+		{
+			if constexpr (detail::HasFields<T>::value)
+			{
+				auto fields = AltConfigFields(static_cast<const T*>(nullptr));
+				MsgPack::EncodeMapHeader(std::tuple_size_v<decltype(fields)>, out);
+
+				std::apply([&](const auto&... field) {
+					((MsgPack::EncodeString(field.name, out), Encode(val.*field.ptr, out)), ...);
+				}, fields);
+			}
+			else if constexpr (detail::IsMap<T>::value)
+			{
+				MsgPack::EncodeMapHeader(val.size(), out);
+				for (auto& curr : val)
+				{
+					MsgPack::EncodeString(curr.first, out);
+					Encode(curr.second, out);
+				}
+			}
+			else if constexpr (detail::IsSequence<T>::value)
+			{
+				MsgPack::EncodeArrayHeader(val.size(), out);
+				for (auto& curr : val)
+					Encode(curr, out);
+			}
+			else
+			{
+				static_assert(std::is_arithmetic_v<T> || std::is_convertible_v<const T&, std::string_view>, "Unsupported field type");
+
+				if constexpr (std::is_arithmetic_v<T>)
+				{
+					auto native = detail::ToNative(val);
+					if (native.kind == detail::NativeScalar::STRING)
+						MsgPack::EncodeString(detail::FormatScalar(val), out);
+					else
+						MsgPack::EncodeNative(native, {}, out);
+				}
+				else
+					MsgPack::EncodeScalar(std::string{ val }, out);
+			}
+		}
+	};
+};
@@ -0,0 +1,341 @@
+#pragma once
+
+#include "alt-config.h"
+
+#include <condition_variable>
+#include <filesystem>
+#include <fstream>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+namespace alt::config
+{
+	namespace detail
+	{
+		// Rough heap footprint of a tree, used for the registry memory budget
+		inline std::size_t EstimateSize(const Node& node)
+		{
+			std::size_t size = sizeof(Node) + 2 * sizeof(void*);
+
+			if (node.IsScalar())
+				size += sizeof(std::string) + node.ToStringView().size();
+			else if (node.IsList())
+			{
+				auto& list = node.ToList();
+				size += list.capacity() * sizeof(Node*);
+				for (auto& curr : list)
+				{
+					if (curr) size += EstimateSize(*curr);
+				}
+			}
+			else if (node.IsDict())
+			{
+				// map node: three pointers, color and the pair
+				for (auto& curr : node.ToDict())
+				{
+					size += 4 * sizeof(void*) + sizeof(Node::Dict::value_type) + curr.first.size();
+					if (curr.second) size += EstimateSize(*curr.second);
+				}
+			}
+
+			return size;
+		}
+	}
+
+	// Process wide cache of parsed and frozen documents keyed by canonical path.
+	// Concurrent loads of the same file are parsed once, documents nobody holds
+	// a reference to are evicted in LRU order once the memory budget is exceeded,
+	// and cached documents are re-parsed when the file changed.
+	class DocumentRegistry
+	{
+	public:
+		// Frozen and shared between threads, so read only
+		using Document = std::shared_ptr<const Node>;
+
+		enum class Validation
+		{
+			// modification time and size
+			MTIME,
+			// re-reads the file and compares its hash, skips only the parsing
+			CONTENT_HASH,
+		};
+
+		static DocumentRegistry& Global()
+		{
+			static DocumentRegistry registry;
+			return registry;
+		}
+
+		DocumentRegistry(std::size_t _budget = 64 * 1024 * 1024, Validation _validation = Validation::MTIME) :
+			budget(_budget),
+			validation(_validation)
+		{
+
+		}
+
+		DocumentRegistry(const DocumentRegistry&) = delete;
+		DocumentRegistry& operator=(const DocumentRegistry&) = delete;
+
+		Document Load(const std::string& path)
+		{
+			std::string key = std::filesystem::weakly_canonical(path).string();
+			std::shared_ptr<Pending> pending;
+
+			while (!pending)
+			{
+				Entry cached;
+
+				{
+					std::unique_lock<std::mutex> lock{ mutex };
+
+					auto it = entries.find(key);
+					if (it != entries.end() && it->second.pending)
+					{
+						// somebody else is already parsing this file
+						auto loading = it->second.pending;
+						lock.unlock();
+						return loading->Wait();
+					}
+
+					if (it == entries.end())
+					{
+						pending = Begin(key);
+						break;
+					}
+
+					cached = it->second;
+				}
+
+				// the file system is only touched without the lock
+				bool valid = IsValid(key, cached);
+
+				std::lock_guard<std::mutex> lock{ mutex };
+
+				// start over if the entry was replaced in the meantime
+				auto it = entries.find(key);
+				if (it == entries.end() || it->second.pending || it->second.doc != cached.doc)
+					continue;
+
+				if (valid)
+				{
+					lru.splice(lru.begin(), lru, it->second.lru);
+					return it->second.doc;
+				}
+
+				Remove(it);
+				pending = Begin(key);
+			}
+
+			Entry loaded;
+			try
+			{
+				loaded = Parse(key);
+			}
+			catch (...)
+			{
+				std::lock_guard<std::mutex> lock{ mutex };
+				Remove(entries.find(key));
+				pending->Fail(std::current_exception());
+				throw;
+			}
+
+			std::lock_guard<std::mutex> lock{ mutex };
+
+			auto& entry = entries.at(key);
+			loaded.lru = entry.lru;
+			entry = std::move(loaded);
+			usage += entry.size;
+
+			Document doc = entry.doc;
+			pending->Finish(doc);
+			Evict();
+
+			return doc;
+		}
+
+		void Invalidate(const std::string& path)
+		{
+			std::string key = std::filesystem::weakly_canonical(path).string();
+
+			std::lock_guard<std::mutex> lock{ mutex };
+			auto it = entries.find(key);
+			if (it != entries.end() && !it->second.pending)
+				Remove(it);
+		}
+
+		void SetBudget(std::size_t _budget)
+		{
+			std::lock_guard<std::mutex> lock{ mutex };
+			budget = _budget;
+			Evict();
+		}
+
+		std::size_t GetMemoryUsage()
+		{
+			std::lock_guard<std::mutex> lock{ mutex };
+			return usage;
+		}
+
+	private:
+		class Pending
+		{
+		public:
+			Document Wait()
+			{
+				std::unique_lock<std::mutex> lock{ mutex };
+				cv.wait(lock, [this]() { return done; });
+
+				if (error)
+					std::rethrow_exception(error);
+				return doc;
+			}
+
+			void Finish(Document _doc)
+			{
+				{
+					std::lock_guard<std::mutex> lock{ mutex };
+					doc = std::move(_doc);
+					done = true;
+				}
+				cv.notify_all();
+			}
+
+			void Fail(std::exception_ptr _error)
+			{
+				{
+					std::lock_guard<std::mutex> lock{ mutex };
+					error = _error;
+					done = true;
+				}
+				cv.notify_all();
+			}
+
+		private:
+			std::mutex mutex;
+			std::condition_variable cv;
+			bool done = false;
+			Document doc;
+			std::exception_ptr error;
+		};
+
+		struct Entry
+		{
+			Document doc;
+			std::shared_ptr<Pending> pending;
+			std::list<std::string>::iterator lru;
+			std::size_t size = 0;
+
+			std::filesystem::file_time_type mtime;
+			uintmax_t fileSize = 0;
+			uint64_t hash = 0;
+		};
+
+		// Adds the placeholder for a file that is about to be parsed, the lock
+		// has to be held
+		std::shared_ptr<Pending> Begin(const std::string& key)
+		{
+			auto pending = std::make_shared<Pending>();
+			lru.push_front(key);
+
+			Entry entry;
+			entry.pending = pending;
+			entry.lru = lru.begin();
+			entries.emplace(key, std::move(entry));
+
+			return pending;
+		}
+
+		static std::vector<char> ReadFile(const std::string& path)
+		{
+			std::ifstream file{ path, std::ios::binary };
+			if (!file)
+				throw Error("Failed to open " + path);
+
+			return { std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>() };
+		}
+
+		static uint64_t HashBuffer(const std::vector<char>& buffer)
+		{
+			return detail::Hash({ buffer.data(), buffer.size() });
+		}
+
+		Entry Parse(const std::string& path)
+		{
+			Entry entry;
+			std::error_code ec;
+			entry.mtime = std::filesystem::last_write_time(path, ec);
+			if (!ec)
+				entry.fileSize = std::filesystem::file_size(path, ec);
+			if (ec)
+				throw Error("Failed to open " + path);
+
+			auto buffer = ReadFile(path);
+			entry.hash = HashBuffer(buffer);
+
+			Parser parser{ buffer };
+			auto doc = std::make_shared<Node>(parser.Parse());
+			doc->Freeze();
+			entry.size = detail::EstimateSize(*doc);
+			entry.doc = std::move(doc);
+
+			return entry;
+		}
+
+		bool IsValid(const std::string& path, const Entry& entry)
+		{
+			std::error_code ec;
+
+			if (validation == Validation::MTIME)
+			{
+				auto mtime = std::filesystem::last_write_time(path, ec);
+				if (ec)
+					return false;
+
+				auto fileSize = std::filesystem::file_size(path, ec);
+				return !ec && mtime == entry.mtime && fileSize == entry.fileSize;
+			}
+
+			try
+			{
+				return HashBuffer(ReadFile(path)) == entry.hash;
+			}
+			catch (const Error&)
+			{
+				return false;
+			}
+		}
+
+		void Remove(std::unordered_map<std::string, Entry>::iterator it)
+		{
+			usage -= it->second.size;
+			lru.erase(it->second.lru);
+			entries.erase(it);
+		}
+
+		// Only drops documents that are referenced by the registry alone
+		void Evict()
+		{
+			auto it = lru.end();
+			while (usage > budget && it != lru.begin())
+			{
+				--it;
+
+				auto entry = entries.find(*it);
+				if (entry->second.pending || entry->second.doc.use_count() > 1)
+					continue;
+
+				auto next = std::next(it);
+				Remove(entry);
+				it = next;
+			}
+		}
+
+		std::mutex mutex;
+		std::unordered_map<std::string, Entry> entries;
+		std::list<std::string> lru;
+		std::size_t usage = 0;
+		std::size_t budget;
+		Validation validation;
+	};
+};
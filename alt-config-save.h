@@ -0,0 +1,209 @@
+#pragma once
+
+#include "alt-config.h"
+
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <mutex>
+#include <thread>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace alt::config
+{
+	namespace detail
+	{
+		// Flushes the contents of a closed file to the disk
+		inline bool SyncFile(const std::string& path)
+		{
+#ifdef _WIN32
+			HANDLE file = CreateFileA(path.c_str(), GENERIC_WRITE, 0, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+			if (file == INVALID_HANDLE_VALUE)
+				return false;
+
+			bool ok = FlushFileBuffers(file);
+			CloseHandle(file);
+			return ok;
+#else
+			int fd = open(path.c_str(), O_RDONLY);
+			if (fd < 0)
+				return false;
+
+			bool ok = fsync(fd) == 0;
+			close(fd);
+			return ok;
+#endif
+		}
+
+		// Replaces path with temp, the rename itself is synced as well
+		inline bool ReplaceFile(const std::string& temp, const std::string& path)
+		{
+#ifdef _WIN32
+			return MoveFileExA(temp.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH);
+#else
+			if (std::rename(temp.c_str(), path.c_str()) != 0)
+				return false;
+
+			std::string dir = std::filesystem::path(path).parent_path().string();
+			int fd = open(dir.empty() ? "." : dir.c_str(), O_RDONLY | O_DIRECTORY);
+			if (fd < 0)
+				return false;
+
+			bool ok = fsync(fd) == 0;
+			close(fd);
+			return ok;
+#endif
+		}
+	}
+
+	// Saves documents on a background thread. SaveAsync copies the document
+	// on the calling thread, so the caller may keep modifying it right away,
+	// also through references taken before. Emitting, writing and syncing run
+	// on the worker. Every file is emitted and synced next to its target and
+	// renamed over it, so readers never see a partial file, not even after a
+	// crash. Saves run in the order they were requested.
+	class Saver
+	{
+	public:
+		static Saver& Global()
+		{
+			static Saver saver;
+			return saver;
+		}
+
+		Saver() = default;
+		Saver(const Saver&) = delete;
+		Saver& operator=(const Saver&) = delete;
+
+		// Pending saves are still written
+		~Saver()
+		{
+			{
+				std::lock_guard<std::mutex> lock{ mutex };
+				stop = true;
+			}
+			cv.notify_all();
+
+			if (worker.joinable())
+				worker.join();
+		}
+
+		// The future reports write errors
+		std::future<void> SaveAsync(Node& doc, const std::string& path)
+		{
+			Job job;
+			job.path = path;
+			job.doc = Snapshot(doc);
+			auto result = job.done.get_future();
+
+			{
+				std::lock_guard<std::mutex> lock{ mutex };
+				if (!worker.joinable())
+					worker = std::thread(&Saver::Run, this);
+
+				queue.push_back(std::move(job));
+			}
+			cv.notify_one();
+
+			return result;
+		}
+
+		// Blocking variant, also used by the worker
+		static void Save(Node& doc, const std::string& path)
+		{
+			std::string temp = path + ".tmp";
+
+			{
+				std::ofstream file{ temp, std::ios::binary | std::ios::trunc };
+				if (!file)
+					throw Error("Failed to open " + temp);
+
+				Emitter::Emit(doc, file);
+				file.flush();
+				if (!file)
+					throw Error("Failed to write " + temp);
+			}
+
+			if (!detail::SyncFile(temp))
+			{
+				std::error_code ec;
+				std::filesystem::remove(temp, ec);
+				throw Error("Failed to sync " + temp);
+			}
+
+			if (!detail::ReplaceFile(temp, path))
+			{
+				std::error_code ec;
+				std::filesystem::remove(temp, ec);
+				throw Error("Failed to replace " + path);
+			}
+		}
+
+	private:
+		struct Job
+		{
+			std::string path;
+			std::unique_ptr<Node> doc;
+			std::promise<void> done;
+		};
+
+		// A deep copy, Share() would not cover writes through references into
+		// the document the caller already holds. The worker owns the copy.
+		static std::unique_ptr<Node> Snapshot(Node& doc)
+		{
+			return std::unique_ptr<Node>(new Node(doc));
+		}
+
+		void Run()
+		{
+			std::unique_lock<std::mutex> lock{ mutex };
+
+			while (true)
+			{
+				cv.wait(lock, [this]() { return stop || !queue.empty(); });
+				if (queue.empty())
+					break;
+
+				Job job = std::move(queue.front());
+				queue.pop_front();
+				lock.unlock();
+
+				try
+				{
+					Save(*job.doc, job.path);
+					job.done.set_value();
+				}
+				catch (...)
+				{
+					job.done.set_exception(std::current_exception());
+				}
+				job.doc.reset();
+
+				lock.lock();
+			}
+		}
+
+		std::mutex mutex;
+		std::condition_variable cv;
+		std::deque<Job> queue;
+		bool stop = false;
+		std::thread worker;
+	};
+
+	inline std::future<void> SaveAsync(Node& doc, const std::string& path) { return Saver::Global().SaveAsync(doc, path); }
+};
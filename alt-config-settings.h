@@ -0,0 +1,383 @@
+#pragma once
+
+#include "alt-config.h"
+
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <deque>
+#include <limits>
+#include <memory>
+#include <thread>
+#include <type_traits>
+
+namespace alt::config
+{
+	namespace detail
+	{
+		template<class T>
+		T ConvertSetting(Node& node)
+		{
+			if constexpr (std::is_same_v<T, std::string>)
+				return node.ToString();
+			else if constexpr (std::is_same_v<T, bool>)
+				return node.ToBool();
+			else if constexpr (std::is_integral_v<T>)
+			{
+				// integers are taken as they are, going through double would
+				// round everything above 2^53
+				NativeScalar native = node.ToNative();
+				if (native.kind == NativeScalar::INT)
+				{
+					if (!std::is_signed_v<T> || native.i < static_cast<int64_t>(std::numeric_limits<T>::min()))
+						throw Error("Out of range");
+					return static_cast<T>(native.i);
+				}
+				else if (native.kind == NativeScalar::UINT)
+				{
+					if (native.u > static_cast<uint64_t>(std::numeric_limits<T>::max()))
+						throw Error("Out of range");
+					return static_cast<T>(native.u);
+				}
+
+				double val = node.ToNumber();
+				if (std::trunc(val) != val)
+					throw Error("Not an integer");
+				// max() is not exact as a double for 64 bit types, 2^digits is,
+				// and so is -2^digits == min() for signed ones
+				double limit = std::ldexp(1.0, std::numeric_limits<T>::digits);
+				if (val >= limit || val < (std::is_signed_v<T> ? -limit : 0.0))
+					throw Error("Out of range");
+				return static_cast<T>(val);
+			}
+			else
+				return static_cast<T>(node.ToNumber());
+		}
+	}
+
+	// Settings are declared once and resolved against a document on every Load.
+	// Every setting has its own cell that Load replaces with a single atomic
+	// store, so readers on any thread never lock. A reader taking several
+	// settings while a Load runs may see some of them already updated. Load and
+	// declaring settings have to run on one thread at a time.
+	class SettingsRegistry
+	{
+	public:
+		static SettingsRegistry& Global()
+		{
+			static SettingsRegistry registry;
+			return registry;
+		}
+
+		SettingsRegistry() = default;
+		SettingsRegistry(const SettingsRegistry&) = delete;
+		SettingsRegistry& operator=(const SettingsRegistry&) = delete;
+
+		~SettingsRegistry()
+		{
+			for (auto& cell : strings)
+				delete cell.load(std::memory_order_relaxed);
+		}
+
+		// Resolves, converts and validates every registered setting. Values are
+		// only replaced if all of them succeed, otherwise the previous values are
+		// kept and an Error listing every failure is thrown.
+		void Load(Node& root)
+		{
+			std::vector<Staged> staged(entries.size());
+			std::string errors;
+
+			for (std::size_t i = 0; i < entries.size(); i++)
+			{
+				auto& entry = entries[i];
+				if (!entry.resolve)
+					continue;
+
+				try
+				{
+					entry.resolve(Find(root, entry.keys), staged[i]);
+				}
+				catch (const Error& e)
+				{
+					errors += entry.path + ": " + e.what() + "\n";
+				}
+			}
+
+			if (!errors.empty())
+				throw Error(errors);
+
+			std::vector<const std::string*> replaced;
+			for (std::size_t i = 0; i < entries.size(); i++)
+			{
+				auto& entry = entries[i];
+				if (!entry.resolve)
+					continue;
+
+				if (entry.string)
+					replaced.push_back(entry.string->exchange(staged[i].string.release(), std::memory_order_acq_rel));
+				else
+					entry.number->store(staged[i].number, std::memory_order_release);
+			}
+
+			Reclaim(replaced);
+		}
+
+	private:
+		template<class T>
+		friend class Setting;
+
+		// Value of a setting before Load stores it
+		struct Staged
+		{
+			// bit pattern of the bool or number
+			uint64_t number = 0;
+			std::unique_ptr<const std::string> string;
+		};
+
+		struct Entry
+		{
+			std::string path;
+			std::vector<std::string> keys;
+			// converts the value (or the default if node is null) into staged
+			std::function<void(Node* node, Staged& staged)> resolve;
+			// one of them is set
+			std::atomic<uint64_t>* number = nullptr;
+			std::atomic<const std::string*>* string = nullptr;
+		};
+
+		std::size_t Register(const std::string& path, bool string, std::function<void(Node*, Staged&)> resolve)
+		{
+			Entry entry;
+			entry.path = path;
+
+			std::size_t begin = 0;
+			while (true)
+			{
+				std::size_t end = path.find('.', begin);
+				entry.keys.push_back(path.substr(begin, end - begin));
+				if (end == std::string::npos)
+					break;
+				begin = end + 1;
+			}
+
+			Staged def;
+			resolve(nullptr, def);
+			entry.resolve = std::move(resolve);
+
+			// cells never move, readers access them without the registry
+			if (string)
+				entry.string = &strings.emplace_back(def.string.release());
+			else
+				entry.number = &numbers.emplace_back(def.number);
+
+			entries.push_back(std::move(entry));
+			return entries.size() - 1;
+		}
+
+		void Unregister(std::size_t entry) { entries[entry].resolve = nullptr; }
+
+		// Strings are read through a pointer that Load replaces. Readers
+		// announce themselves in the counter of the current epoch, Load
+		// switches the epoch and frees the replaced strings once the readers of
+		// the previous one are done.
+		std::string Read(const std::atomic<const std::string*>& cell) const
+		{
+			uint32_t curr;
+			while (true)
+			{
+				curr = epoch.load(std::memory_order_seq_cst) & 1;
+				readers[curr].fetch_add(1, std::memory_order_seq_cst);
+				if ((epoch.load(std::memory_order_seq_cst) & 1) == curr)
+					break;
+				readers[curr].fetch_sub(1, std::memory_order_release);
+			}
+
+			std::string val = *cell.load(std::memory_order_acquire);
+			readers[curr].fetch_sub(1, std::memory_order_release);
+			return val;
+		}
+
+		void Reclaim(std::vector<const std::string*>& replaced)
+		{
+			if (replaced.empty())
+				return;
+
+			uint32_t prev = epoch.fetch_add(1, std::memory_order_seq_cst) & 1;
+			while (readers[prev].load(std::memory_order_acquire) != 0)
+				std::this_thread::yield();
+
+			for (auto str : replaced)
+				delete str;
+		}
+
+		static Node* Find(Node& root, const std::vector<std::string>& keys)
+		{
+			Node* node = &root;
+			for (auto& key : keys)
+			{
+				node = node->Find(key);
+				if (!node)
+					return nullptr;
+			}
+
+			if (!node || node->IsNone())
+				return nullptr;
+			return node;
+		}
+
+		std::vector<Entry> entries;
+		// deques keep the address of every cell when settings are added
+		std::deque<std::atomic<uint64_t>> numbers;
+		std::deque<std::atomic<const std::string*>> strings;
+		std::atomic<uint32_t> epoch{ 0 };
+		mutable std::atomic<uint32_t> readers[2] = { 0, 0 };
+	};
+
+	template<class T>
+	class Setting
+	{
+		static_assert(std::is_arithmetic_v<T> || std::is_same_v<T, std::string>, "Setting only supports bool, numbers and std::string");
+
+	public:
+		using Validator = std::function<bool(const T&)>;
+
+		Setting(const std::string& path, const T& def, Validator validator = nullptr, SettingsRegistry& _registry = SettingsRegistry::Global()) :
+			registry(_registry)
+		{
+			entry = registry.Register(path, std::is_same_v<T, std::string>, [def, validator](Node* node, SettingsRegistry::Staged& staged) {
+				T val = node ? detail::ConvertSetting<T>(*node) : def;
+
+				if (node && validator && !validator(val))
+					throw Error("Validation failed");
+
+				Store(staged, val);
+			});
+
+			if constexpr (std::is_same_v<T, std::string>)
+				cell = registry.entries[entry].string;
+			else
+				cell = registry.entries[entry].number;
+		}
+
+		Setting(const Setting&) = delete;
+		Setting& operator=(const Setting&) = delete;
+
+		~Setting() { registry.Unregister(entry); }
+
+		T Get() const
+		{
+			if constexpr (std::is_same_v<T, std::string>)
+				return registry.Read(*cell);
+			else
+			{
+				uint64_t bits = cell->load(std::memory_order_acquire);
+
+				if constexpr (std::is_same_v<T, bool>)
+					return bits != 0;
+				else if constexpr (std::is_integral_v<T>)
+					return static_cast<T>(bits);
+				else
+				{
+					double val;
+					std::memcpy(&val, &bits, sizeof(val));
+					return static_cast<T>(val);
+				}
+			}
+		}
+
+		operator T() const { return Get(); }
+
+	private:
+		static void Store(SettingsRegistry::Staged& staged, const T& val)
+		{
+			if constexpr (std::is_same_v<T, std::string>)
+				staged.string = std::make_unique<const std::string>(val);
+			else if constexpr (std::is_same_v<T, bool>)
+				staged.number = val ? 1 : 0;
+			else if constexpr (std::is_integral_v<T>)
+				staged.number = static_cast<uint64_t>(val);
+			else
+			{
+				double d = static_cast<double>(val);
+				std::memcpy(&staged.number, &d, sizeof(d));
+			}
+		}
+
+		using Cell = std::conditional_t<std::is_same_v<T, std::string>, std::atomic<const std::string*>, std::atomic<uint64_t>>;
+
+		SettingsRegistry& registry;
+		std::size_t entry;
+		Cell* cell;
+	};
+
+	// Single value that can be changed at runtime without locking. Reads and
+	// writes are one atomic access, any thread may call Set() and readers never
+	// wait on writers. Changes only reach the document through WriteBack(),
+	// which has to run where the document may be modified.
+	template<class T>
+	class Tunable
+	{
+		static_assert(std::is_arithmetic_v<T>, "Tunable only supports bool and numbers");
+		static_assert(std::atomic<T>::is_always_lock_free, "Tunable needs a lock free atomic");
+
+	public:
+		Tunable(const std::string& _path, T def) :
+			path(_path),
+			value(def)
+		{
+
+		}
+
+		Tunable(const Tunable&) = delete;
+		Tunable& operator=(const Tunable&) = delete;
+
+		// Takes the value at the dotted path, keeps the current one if it is
+		// missing. Pending changes are dropped.
+		void Load(Node& root)
+		{
+			Node* node = root.GetMany({ path })[0];
+			if (node && !node->IsNone())
+				value.store(detail::ConvertSetting<T>(*node), std::memory_order_relaxed);
+			dirty.store(false, std::memory_order_relaxed);
+		}
+
+		T Get() const { return value.load(std::memory_order_relaxed); }
+		operator T() const { return Get(); }
+
+		void Set(T val)
+		{
+			value.store(val, std::memory_order_relaxed);
+			dirty.store(true, std::memory_order_release);
+		}
+
+		Tunable& operator=(T val)
+		{
+			Set(val);
+			return *this;
+		}
+
+		// Stores the value at its path if it changed since the last Load or
+		// WriteBack, returns whether it did
+		bool WriteBack(Node& root)
+		{
+			if (!dirty.exchange(false, std::memory_order_acquire))
+				return false;
+
+			T val = Get();
+			if constexpr (std::is_same_v<T, bool> || std::is_floating_point_v<T>)
+				root.SetMany({ { path, Node(val) } });
+			else if constexpr (std::is_signed_v<T>)
+				root.SetMany({ { path, Node(static_cast<int64_t>(val)) } });
+			else
+				root.SetMany({ { path, Node(static_cast<uint64_t>(val)) } });
+			return true;
+		}
+
+		const std::string& GetPath() const { return path; }
+
+	private:
+		std::string path;
+		std::atomic<T> value;
+		std::atomic<bool> dirty{ false };
+	};
+};
@@ -0,0 +1,129 @@
+#pragma once
+
+#include "alt-config-registry.h"
+
+namespace alt::config
+{
+	// One logical document split across shard files. A small index file maps
+	// each top-level key to the shard holding it:
+	//
+	// players: 'players.cfg'
+	// region-eu: 'regions/eu.cfg'
+	// region-us: 'regions/us.cfg'
+	//
+	// Relative paths are resolved against the directory of the index. A shard
+	// is parsed through the registry on first access and can be evicted by its
+	// memory budget once no returned subtree keeps it alive.
+	class ShardedConfig
+	{
+	public:
+		using Document = DocumentRegistry::Document;
+
+		ShardedConfig(const std::string& indexPath, DocumentRegistry& _registry = DocumentRegistry::Global()) :
+			registry(_registry)
+		{
+			std::ifstream file{ indexPath, std::ios::binary };
+			if (!file)
+				throw Error("Failed to open " + indexPath);
+
+			Parser parser{ file };
+			Node index = parser.Parse();
+			if (!index.IsDict())
+				throw Error("Shard index is not a dict");
+
+			auto dir = std::filesystem::path(indexPath).parent_path();
+			std::unordered_map<std::string, std::size_t> files;
+
+			for (auto& curr : static_cast<const Node&>(index).ToDict())
+			{
+				if (!curr.second || !curr.second->IsScalar())
+					throw Error("Shard of " + curr.first + " is not a path");
+
+				std::string path = (dir / curr.second->ToString()).lexically_normal().string();
+
+				auto it = files.find(path);
+				if (it == files.end())
+				{
+					it = files.emplace(path, shards.size()).first;
+					shards.push_back({ path, {} });
+				}
+
+				keys.emplace(curr.first, it->second);
+			}
+		}
+
+		ShardedConfig(const ShardedConfig&) = delete;
+		ShardedConfig& operator=(const ShardedConfig&) = delete;
+
+		// Subtree of a top-level key, loading its shard if needed. The result
+		// keeps the whole shard alive, nullptr if the key is unknown or the
+		// shard does not contain it.
+		Document Get(const std::string& key)
+		{
+			auto it = keys.find(key);
+			if (it == keys.end())
+				return nullptr;
+
+			Document shard = Load(shards[it->second]);
+			const Node* node = shard->Find(key);
+			if (!node || node->IsNone())
+				return nullptr;
+
+			return Document(std::move(shard), node);
+		}
+
+		Document operator[](const std::string& key) { return Get(key); }
+
+		bool Contains(const std::string& key) const { return keys.count(key) > 0; }
+
+		// Top-level keys listed in the index
+		std::vector<std::string> Keys() const
+		{
+			std::vector<std::string> result;
+			result.reserve(keys.size());
+			for (auto& curr : keys)
+				result.push_back(curr.first);
+			return result;
+		}
+
+		// Whether the shard of key is currently in memory
+		bool IsLoaded(const std::string& key)
+		{
+			auto it = keys.find(key);
+			if (it == keys.end())
+				return false;
+
+			std::lock_guard<std::mutex> lock{ mutex };
+			return !shards[it->second].doc.expired();
+		}
+
+	private:
+		struct Shard
+		{
+			std::string path;
+			// does not keep the shard from being evicted
+			std::weak_ptr<const Node> doc;
+		};
+
+		Document Load(Shard& shard)
+		{
+			{
+				std::lock_guard<std::mutex> lock{ mutex };
+				if (Document doc = shard.doc.lock())
+					return doc;
+			}
+
+			// the registry already parses concurrent loads of a file once
+			Document doc = registry.Load(shard.path);
+
+			std::lock_guard<std::mutex> lock{ mutex };
+			shard.doc = doc;
+			return doc;
+		}
+
+		DocumentRegistry& registry;
+		std::map<std::string, std::size_t> keys;
+		std::vector<Shard> shards;
+		std::mutex mutex;
+	};
+};
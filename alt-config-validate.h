@@ -0,0 +1,164 @@
+#pragma once
+
+#include "alt-config.h"
+
+#include <mutex>
+
+namespace alt::config
+{
+	// Remembers validation results by the contents of the validated subtree, so
+	// sections that did not change since the last reload are not validated
+	// again. Validators are told apart by id and have to depend on nothing but
+	// the subtree. Results are found by Node::Fingerprint() and kept along with
+	// a copy of the validated subtree, which a hit is compared against, so a
+	// hash collision only costs a validation. Nothing is written to the
+	// validated nodes, validations may run concurrently on a frozen document
+	// like the ones of the DocumentRegistry.
+	class ValidationCache
+	{
+	public:
+		// Throws Error if node is invalid
+		using Validator = std::function<void(const Node& node)>;
+
+		static ValidationCache& Global()
+		{
+			static ValidationCache cache;
+			return cache;
+		}
+
+		ValidationCache() = default;
+		ValidationCache(const ValidationCache&) = delete;
+		ValidationCache& operator=(const ValidationCache&) = delete;
+
+		// Runs validator on node unless it already ran on equal contents.
+		// Failures are cached as well and thrown again.
+		void Validate(const Node& node, const std::string& id, const Validator& validator)
+		{
+			ResultKey key{ id, node.Fingerprint() };
+
+			{
+				std::lock_guard<std::mutex> lock{ mutex };
+
+				auto it = results.find(key);
+				if (it != results.end() && Equal(it->second.contents, node))
+				{
+					it->second.used = true;
+					if (!it->second.valid)
+						throw it->second.error;
+					return;
+				}
+			}
+
+			Result result{ node };
+			try
+			{
+				validator(node);
+			}
+			catch (const Error& e)
+			{
+				result.valid = false;
+				result.error = e;
+			}
+
+			{
+				std::lock_guard<std::mutex> lock{ mutex };
+				// replaces a colliding result
+				results.insert_or_assign(std::move(key), result);
+			}
+
+			if (!result.valid)
+				throw result.error;
+		}
+
+		// Drops results that were not used since the last sweep, call it after
+		// each reload to bound the cache
+		void Sweep()
+		{
+			std::lock_guard<std::mutex> lock{ mutex };
+
+			for (auto it = results.begin(); it != results.end();)
+			{
+				if (!it->second.used)
+					it = results.erase(it);
+				else
+				{
+					it->second.used = false;
+					++it;
+				}
+			}
+		}
+
+		void Clear()
+		{
+			std::lock_guard<std::mutex> lock{ mutex };
+			results.clear();
+		}
+
+		std::size_t Size()
+		{
+			std::lock_guard<std::mutex> lock{ mutex };
+			return results.size();
+		}
+
+	private:
+		// validator id and fingerprint
+		using ResultKey = std::pair<std::string, uint64_t>;
+
+		struct Result
+		{
+			Node contents;
+			bool valid = true;
+			bool used = true;
+			Error error{ "" };
+		};
+
+		// Equal contents, empty entries are skipped like copying does
+		static bool Equal(const Node& a, const Node& b)
+		{
+			if (a.IsScalar() || b.IsScalar())
+				return a.IsScalar() && b.IsScalar() && a.ToStringView() == b.ToStringView();
+			if (a.IsList() && b.IsList())
+				return EqualEntries(a.ToList(), b.ToList());
+			if (a.IsDict() && b.IsDict())
+				return EqualEntries(a.ToDict(), b.ToDict());
+
+			return a.IsNone() && b.IsNone();
+		}
+
+		// dicts are sorted, so both are walked in order without lookups, which
+		// could build the index of a dict
+		template<class Container>
+		static bool EqualEntries(const Container& a, const Container& b)
+		{
+			auto it = a.begin();
+			auto other = b.begin();
+			while (true)
+			{
+				while (it != a.end() && IsEmpty(*it))
+					++it;
+				while (other != b.end() && IsEmpty(*other))
+					++other;
+
+				if (it == a.end() || other == b.end())
+					return it == a.end() && other == b.end();
+
+				if constexpr (std::is_same_v<Container, Node::Dict>)
+				{
+					if (it->first != other->first || !Equal(*it->second, *other->second))
+						return false;
+				}
+				else if (!Equal(**it, **other))
+					return false;
+
+				++it;
+				++other;
+			}
+		}
+
+		static bool IsEmpty(const Node* node) { return !node || node->IsNone(); }
+		static bool IsEmpty(const Node::Dict::value_type& entry) { return IsEmpty(entry.second); }
+
+		std::mutex mutex;
+		std::map<ResultKey, Result> results;
+	};
+};
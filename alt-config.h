@@ -8,6 +8,19 @@
 #include <iostream>
 #include <algorithm>
 #include <cctype>
+#include <functional>
+#include <utility>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <atomic>
+#include <memory>
+#include <type_traits>
+#include <limits>
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>
+#include <new>
 
 namespace alt::config
 {
@@ -100,17 +113,241 @@ namespace alt::config
 	public:
 		Error(const std::string& _err, size_t _pos = 0, size_t _line = 0, size_t _column = 0) : err{ _err }, pos{ _pos }, lin{ _line }, col{ _column } { }
 		const char* what() const noexcept override { return err.c_str(); }
-		const size_t position() const { return pos; }
-		const size_t line() const { return lin; }
-		const size_t column() const { return col; }
+		size_t position() const { return pos; }
+		size_t line() const { return lin; }
+		size_t column() const { return col; }
 	};
 
+	namespace detail
+	{
+		inline std::string FormatNumber(double val)
+		{
+			std::ostringstream ss;
+			ss.precision(15);
+			ss << val;
+			return ss.str();
+		}
+
+		// Native type of a scalar as binary formats write it. Text maps to a
+		// native type only if it is exactly what that value would be formatted
+		// as, see Node::ToNative().
+		struct NativeScalar
+		{
+			enum Kind
+			{
+				STRING,
+				BOOL,
+				INT,
+				UINT,
+				DOUBLE
+			} kind = STRING;
+
+			bool b = false;
+			int64_t i = 0;
+			uint64_t u = 0;
+			double d = 0;
+
+			static NativeScalar FromBool(bool val)
+			{
+				NativeScalar res;
+				res.kind = BOOL;
+				res.b = val;
+				return res;
+			}
+
+			static NativeScalar FromInt(int64_t val)
+			{
+				if (val >= 0)
+					return FromUInt(static_cast<uint64_t>(val));
+
+				NativeScalar res;
+				res.kind = INT;
+				res.i = val;
+				return res;
+			}
+
+			static NativeScalar FromUInt(uint64_t val)
+			{
+				NativeScalar res;
+				res.kind = UINT;
+				res.u = val;
+				return res;
+			}
+
+			// infinity and NaN stay text
+			static NativeScalar FromDouble(double val)
+			{
+				NativeScalar res;
+				if (std::isfinite(val))
+				{
+					res.kind = DOUBLE;
+					res.d = val;
+				}
+				return res;
+			}
+
+			static NativeScalar Classify(const std::string& str)
+			{
+				NativeScalar res;
+
+				if (str == "true" || str == "false")
+				{
+					res.kind = BOOL;
+					res.b = str == "true";
+					return res;
+				}
+
+				if (str.empty())
+					return res;
+
+				bool negative = str[0] == '-';
+				std::size_t digits = negative ? 1 : 0;
+				bool integer = digits < str.size() && std::all_of(str.begin() + digits, str.end(), [](char c) { return c >= '0' && c <= '9'; });
+
+				if (integer)
+				{
+					// no leading zeros and no negative zero
+					if (str[digits] == '0' && (str.size() > digits + 1 || negative))
+						return res;
+
+					errno = 0;
+					if (negative)
+					{
+						res.i = std::strtoll(str.c_str(), nullptr, 10);
+						res.kind = INT;
+					}
+					else
+					{
+						res.u = std::strtoull(str.c_str(), nullptr, 10);
+						res.kind = UINT;
+					}
+
+					if (errno == ERANGE)
+						res.kind = STRING;
+					return res;
+				}
+
+				char* end;
+				double val = std::strtod(str.c_str(), &end);
+				if (end != str.c_str() + str.size() || !std::isfinite(val) || FormatNumber(val) != str)
+					return res;
+
+				res.kind = DOUBLE;
+				res.d = val;
+				return res;
+			}
+		};
+
+		// FNV-1a, pass the previous result as hash to continue it
+		constexpr uint64_t Hash(std::string_view str, uint64_t hash = 14695981039346656037ull)
+		{
+			for (char c : str)
+			{
+				hash ^= static_cast<unsigned char>(c);
+				hash *= 1099511628211ull;
+			}
+			return hash;
+		}
+
+		// Bump allocator for the trees of Node::Compact() and BatchParser. Memory
+		// comes in aligned blocks that count the objects placed in them, a block
+		// is freed together with its last object on whichever thread that
+		// happens, so a surviving node only keeps its own block alive.
+		class Arena
+		{
+		public:
+			Arena() = default;
+			Arena(const Arena&) = delete;
+			Arena& operator=(const Arena&) = delete;
+
+			// the objects keep their blocks alive
+			~Arena() { Retire(); }
+
+			// nullptr if size does not fit a block, the caller takes the heap then
+			void* Allocate(std::size_t size, std::size_t align)
+			{
+				if (size > BLOCK_SIZE - sizeof(Block))
+					return nullptr;
+
+				std::size_t pos = (used + align - 1) & ~(align - 1);
+				if (!block || pos + size > BLOCK_SIZE)
+				{
+					Retire();
+					block = new (::operator new(BLOCK_SIZE, std::align_val_t{ BLOCK_SIZE })) Block;
+					pos = (sizeof(Block) + align - 1) & ~(align - 1);
+				}
+
+				block->live.fetch_add(1, std::memory_order_relaxed);
+				used = pos + size;
+				return reinterpret_cast<char*>(block) + pos;
+			}
+
+			static void Free(void* ptr)
+			{
+				Release(reinterpret_cast<Block*>(reinterpret_cast<std::uintptr_t>(ptr) & ~(BLOCK_SIZE - 1)));
+			}
+
+		private:
+			static constexpr std::size_t BLOCK_SIZE = 4096;
+
+			struct Block
+			{
+				// objects in the block plus one while the arena allocates from it
+				std::atomic<std::size_t> live{ 1 };
+			};
+
+			static void Release(Block* block)
+			{
+				if (block->live.fetch_sub(1, std::memory_order_acq_rel) != 1)
+					return;
+
+				block->~Block();
+				::operator delete(block, std::align_val_t{ BLOCK_SIZE });
+			}
+
+			// no more allocations from the current block
+			void Retire()
+			{
+				if (block)
+					Release(block);
+				block = nullptr;
+			}
+
+			Block* block = nullptr;
+			std::size_t used = 0;
+		};
+	}
+
+	// Dict key with a precomputed hash, literals are hashed at compile time:
+	// node["tickrate"_key]
+	class Key
+	{
+	public:
+		constexpr Key(const char* str, std::size_t len) : view(str, len), hash(detail::Hash(view)) { }
+		template<std::size_t N>
+		constexpr Key(const char (&str)[N]) : Key(str, N - 1) { }
+		Key(const std::string& str) : Key(str.data(), str.size()) { }
+
+		constexpr std::string_view String() const { return view; }
+		constexpr uint64_t Hash() const { return hash; }
+
+	private:
+		std::string_view view;
+		uint64_t hash;
+	};
+
+	namespace literals
+	{
+		constexpr Key operator""_key(const char* str, std::size_t len) { return { str, len }; }
+	}
+
 	class Node
 	{
 	public:
 		using Scalar = std::string;
 		using List = std::vector<Node*>;
-		using Dict = std::map<std::string, Node*>;
+		// transparent, lookups by std::string_view don't allocate
+		using Dict = std::map<std::string, Node*, std::less<>>;
 
 		enum class Type
 		{
@@ -134,27 +371,32 @@ namespace alt::config
 
 		}
 
+		// Numbers and bools are stored natively and only formatted when the
+		// text is needed
 		Node(bool _val) :
 			type(Type::SCALAR),
-			val(new ValueScalar{ _val ? "true" : "false" })
+			val(new ValueNative{ _val })
 		{
 
 		}
 
 		Node(double _val) :
-			type(Type::SCALAR)
+			type(Type::SCALAR),
+			val(new ValueNative{ _val })
+		{
+
+		}
+
+		Node(int64_t _val) :
+			type(Type::SCALAR),
+			val(new ValueNative{ _val })
 		{
-			std::ostringstream ss;
-			ss.precision(15);
-			ss << _val;
 
-			val = new ValueScalar{ ss.str() };
 		}
 
-		Node(int val) : Node(static_cast<double>(val)) { }
-		Node(unsigned val) : Node(static_cast<double>(val)) { }
-		Node(int64_t val) : Node(static_cast<double>(val)) { }
-		Node(uint64_t val) : Node(static_cast<double>(val)) { }
+		Node(int val) : Node(static_cast<int64_t>(val)) { }
+		Node(unsigned val) : Node(static_cast<int64_t>(val)) { }
+		Node(uint64_t val) : Node(val <= static_cast<uint64_t>(std::numeric_limits<int64_t>::max()) ? Node(static_cast<int64_t>(val)) : Node(static_cast<double>(val))) { }
 
 		Node(const Scalar& _val) :
 			type(Type::SCALAR),
@@ -163,6 +405,13 @@ namespace alt::config
 
 		}
 
+		Node(Scalar&& _val) :
+			type(Type::SCALAR),
+			val(new ValueScalar{ std::move(_val) })
+		{
+
+		}
+
 		Node(const char* val) : Node(std::string{ val }) { }
 
 		Node(const List& _val) :
@@ -172,12 +421,20 @@ namespace alt::config
 
 		}
 
+		Node(List&& _val) :
+			type(Type::LIST),
+			val(new ValueList{ std::move(_val) })
+		{
+
+		}
+
 		template<class T>
 		Node(const std::vector<T>& _val) :
 			Node(List{ })
 		{
+			// not through ToList(), which would keep the list out of the caches
 			for (auto& v : _val)
-				ToList().push_back(new Node(v));
+				static_cast<ValueList*>(val)->val.push_back(new Node(v));
 		}
 
 		Node(const Dict& _val) :
@@ -187,6 +444,13 @@ namespace alt::config
 
 		}
 
+		Node(Dict&& _val) :
+			type(Type::DICT),
+			val(new ValueDict{ std::move(_val) })
+		{
+
+		}
+
 		Node(const Node& that) :
 			type(that.type),
 			val(that.val->Copy())
@@ -194,58 +458,92 @@ namespace alt::config
 
 		}
 
-		~Node() { delete val; }
+		Node(Node&& that) :
+			type(that.type),
+			val(that.val)
+		{
+			that.type = Type::NONE;
+			that.val = new Value;
+
+			if (val->parent)
+			{
+				val->parent->MarkDirty();
+				that.val->parent = val->parent;
+				val->parent = nullptr;
+			}
+		}
+
+		~Node() { Release(val); }
 
 		Node& operator=(const Node& that)
 		{
+			Value* parent = val->parent;
+
 			type = that.type;
-			delete val;
+			Release(val);
 			val = that.val->Copy();
 
+			val->parent = parent;
+			if (parent)
+				parent->MarkDirty();
+
+			return *this;
+		}
+
+		Node& operator=(Node&& that)
+		{
+			std::swap(type, that.type);
+			std::swap(val, that.val);
+
+			// the emit cache links stay with the position in the tree
+			std::swap(val->parent, that.val->parent);
+			if (val->parent)
+				val->parent->MarkDirty();
+			if (that.val->parent)
+				that.val->parent->MarkDirty();
+
 			return *this;
 		}
 
 		Type GetType()
 		{
-			if (!this) return Type::NONE;
 			return type;
 		}
 
 		bool IsNone() const
 		{
-			if (!this) return true;
 			return type == Type::NONE;
 		}
 		bool IsScalar() const
 		{
-			if (!this) return false;
 			return type == Type::SCALAR;
 		}
 		bool IsList() const
 		{
-			if (!this) return false;
 			return type == Type::LIST;
 		}
 		bool IsDict() const
 		{
-			if (!this) return false;
 			return type == Type::DICT;
 		}
 
-		bool ToBool() {
+		// Scalar stored as the bool or number it was built from instead of text
+		bool IsNative() const { return val->IsNative(); }
+
+		bool ToBool() const
+		{
 			if (!val)
 			{
 				throw Error{ "Invalid cast" };
 			}
 			return val->ToBool();
 		}
-		bool ToBool(bool def)
+		bool ToBool(bool def) const
 		{
-			if (!this) return def;
 			return val->ToBool(def);
 		}
 
-		double ToNumber()
+		double ToNumber() const
 		{
 			if (!val)
 			{
@@ -253,13 +551,12 @@ namespace alt::config
 			}
 			return val->ToNumber();
 		}
-		double ToNumber(double def)
+		double ToNumber(double def) const
 		{
-			if (!this) return def;
 			return val->ToNumber(def);
 		}
 
-		std::string ToString()
+		std::string ToString() const
 		{
 			if (!val)
 			{
@@ -267,18 +564,45 @@ namespace alt::config
 			}
 			return val->ToString();
 		}
-		std::string ToString(const std::string& def)
+		std::string ToString(const std::string& def) const
 		{
-			if (!this) return def;
 			return val->ToString(def);
 		}
 
+		// View of the stored scalar, valid until the node is modified
+		std::string_view ToStringView() const
+		{
+			if (!val)
+			{
+				throw Error{ "Invalid cast" };
+			}
+			return val->ToStringView();
+		}
+
+		// Scalar as the native type binary formats write, bools and numbers the
+		// node was built from are taken as stored and text is classified.
+		// STRING means the text has to be written.
+		detail::NativeScalar ToNative() const
+		{
+			if (!val)
+			{
+				throw Error{ "Invalid cast" };
+			}
+			return val->ToNative();
+		}
+
+		// The caller may modify the container and delete its children. Children
+		// of trees built by Compact() or a BatchParser are moved out of the
+		// arena first, references to them are invalidated. Since later changes
+		// can not be seen, the container is left out of Emitter::EmitCached and
+		// Fingerprint() caches from then on, read through a const node instead.
 		List& ToList()
 		{
 			if (!val)
 			{
 				throw Error{ "Invalid cast" };
 			}
+			Unshare();
 			return val->ToList();
 		}
 		Dict& ToDict()
@@ -287,82 +611,528 @@ namespace alt::config
 			{
 				throw Error{ "Invalid cast" };
 			};
+			Unshare();
 			return val->ToDict();
 		}
 
-		Node& operator[](std::size_t idx) { return val->Get(idx); }
-		Node& operator[](const std::string& key) { return val->Get(key); }
-		Node& operator[](const char* key) { return val->Get(key); }
+		// Read only access, does not drop the lookup tables of the dict
+		const List& ToList() const
+		{
+			return static_cast<const Value*>(val)->ToList();
+		}
+		const Dict& ToDict() const
+		{
+			return static_cast<const Value*>(val)->ToDict();
+		}
+
+		// Looks up a key without inserting it, nullptr if missing or not a dict
+		Node* Find(const Key& key) { return val->Find(key); }
+		const Node* Find(const Key& key) const { return val->Find(key); }
+
+		Node& operator[](std::size_t idx)
+		{
+			UnshareForWrite();
+			return val->Get(idx);
+		}
+		Node& operator[](const std::string& key)
+		{
+			UnshareForWrite();
+			return val->Get(key);
+		}
+		Node& operator[](const char* key)
+		{
+			UnshareForWrite();
+			return val->Get(key);
+		}
+		Node& operator[](const Key& key)
+		{
+			UnshareForWrite();
+			return val->Get(key);
+		}
+
+		// Read only lookups, missing entries give an empty node and are never
+		// inserted
+		const Node& operator[](std::size_t idx) const { return val->Get(idx); }
+		const Node& operator[](const std::string& key) const { return (*this)[Key{ key }]; }
+		const Node& operator[](const char* key) const { return (*this)[Key{ key, std::strlen(key) }]; }
+		const Node& operator[](const Key& key) const
+		{
+			static const Node none;
+
+			const Node* result = Find(key);
+			return result ? *result : none;
+		}
+
+		// Looks up dotted paths ("server.net.port") in a single walk, a prefix
+		// shared by several paths is resolved once. Missing paths give nullptr.
+		std::vector<Node*> GetMany(const std::vector<std::string>& paths)
+		{
+			std::vector<Node*> result(paths.size());
+
+			WalkPaths(paths, [](Node& node, std::string_view key) {
+				return node.Find(Key{ key.data(), key.size() });
+			}, [&](std::size_t idx, Node* node) {
+				result[idx] = node;
+			});
+
+			return result;
+		}
+
+		// Assigns every value at its dotted path, creating missing dicts on the
+		// way. Later entries win if a path is given twice.
+		void SetMany(const std::vector<std::pair<std::string, Node>>& entries)
+		{
+			std::vector<std::string> paths;
+			paths.reserve(entries.size());
+			for (auto& entry : entries)
+				paths.push_back(entry.first);
+
+			WalkPaths(paths, [](Node& node, std::string_view key) {
+				if (node.IsNone())
+					node = Dict{};
+				if (!node.IsDict())
+					throw Error{ "Not a dict" };
+
+				// unlike ToDict() this leaves the other children in place
+				node.Unshare();
+				auto& child = static_cast<ValueDict*>(node.val)->Slot(key);
+				if (!child)
+					child = new Node();
+				return child;
+			}, [&](std::size_t idx, Node* node) {
+				*node = entries[idx].second;
+			});
+		}
 
 		operator bool() { return !IsNone(); }
 
+		// Prepares the tree for read only use: large dicts get a minimal perfect
+		// hash table and lookups of missing keys no longer insert empty nodes.
+		// Missing keys give an empty node through a const reference and Find(),
+		// operator[] on a non-const node throws. Modifying a dict through
+		// ToDict() unfreezes it. Fingerprints are cached beforehand, frozen
+		// values are not written to by Fingerprint().
+		void Freeze()
+		{
+			Fingerprint();
+			val->Freeze();
+		}
+
+		// Copies the tree depth-first into a fresh arena and releases the old
+		// nodes. Nodes and values are laid out in the order they are visited,
+		// along with text short enough for the small string buffer. List and
+		// dict storage and longer text stay on the heap. Empty nodes are
+		// dropped, references into the tree are invalidated and the result is
+		// not frozen.
+		void Compact()
+		{
+			Value* compacted;
+			{
+				detail::Arena arena;
+				compacted = val->CopyTo(arena);
+			}
+
+			compacted->parent = val->parent;
+			if (compacted->parent)
+				compacted->parent->MarkDirty();
+
+			Release(val);
+			val = compacted;
+		}
+
+		// Returns a node referring to the same value instead of a copy, used for
+		// aliases and snapshots. operator[], ToList(), ToDict() and SetMany() copy
+		// a shared value before handing it out, one level at a time: the copy
+		// shares its children, which are copied in turn when they are reached.
+		// Find() and lookups on frozen values never copy, so nothing may be
+		// modified through them.
+		Node Share()
+		{
+			// a dict or list holding a shared value can not be cached, and the
+			// value can not tell which of its holders to dirty
+			val->MarkDirty();
+			val->parent = nullptr;
+
+			val->refs.fetch_add(1, std::memory_order_relaxed);
+			return { type, val };
+		}
+
+		bool IsShared() const { return val->refs > 1; }
+
+		void Unshare()
+		{
+			if (val->refs == 1)
+				return;
+
+			Value* copy = val->Clone();
+			Release(val);
+			val = copy;
+		}
+
+		// Hash of the contents of the tree, equal contents give equal values no
+		// matter how the tree was built. Empty dict entries are ignored like they
+		// are when copying. Lists and dicts keep their hash until something
+		// below them changes, so unchanged subtrees cost O(1). Not synchronized,
+		// like Emitter::EmitCached, but nothing is written below shared or
+		// frozen values.
+		uint64_t Fingerprint()
+		{
+			uint64_t hash;
+			Fingerprint(*this, hash, true);
+			return hash;
+		}
+
+		// Only reads the cached hashes, may run concurrently on a tree nobody
+		// modifies, e.g. a frozen document of the DocumentRegistry
+		uint64_t Fingerprint() const
+		{
+			uint64_t hash;
+			Fingerprint(*this, hash, false);
+			return hash;
+		}
+
 		friend std::ostream& operator<<(std::ostream& os, const Node& node)
 		{
 			node.val->Print(os);
 			return os;
 		}
 
+		friend class SourceMap;
+		friend class Emitter;
+		friend class Parser;
+
 	protected:
 		Node(Type _type) : type(_type) { };
 
 	private:
-		class Value
+		class Value;
+
+		Node(Type _type, Value* _val) : type(_type), val(_val) { }
+
+		static void Release(Value* val)
 		{
-		public:
-			virtual ~Value() = default;
+			if (val->refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+				Destroy(val);
+		}
 
-			virtual Value* Copy() { return new Value; }
+		// Nodes and values are only placed in an arena by Compact() and the
+		// parser of a BatchParser, anything else is a plain heap allocation.
+		// Objects from an arena are flagged and go back to it in Destroy().
+		template<class T, class... Args>
+		static T* Create(detail::Arena* arena, Args&&... args)
+		{
+			void* mem = arena ? arena->Allocate(sizeof(T), alignof(T)) : nullptr;
+			if (!mem)
+				return new T(std::forward<Args>(args)...);
 
-			virtual bool ToBool() { throw Error{ "Invalid cast" }; }
-			virtual bool ToBool(bool def) { return def; }
+			T* obj;
+			try
+			{
+				obj = new (mem) T(std::forward<Args>(args)...);
+			}
+			catch (...)
+			{
+				detail::Arena::Free(mem);
+				throw;
+			}
 
-			virtual double ToNumber() { throw Error{ "Invalid cast" }; }
-			virtual double ToNumber(double def) { return def; }
+			obj->inArena = true;
+			return obj;
+		}
 
-			virtual std::string ToString() { throw Error{ "Invalid cast" }; }
-			virtual std::string ToString(const std::string& def) { return def; }
+		template<class T>
+		static void Destroy(T* obj)
+		{
+			if (!obj || !obj->inArena)
+			{
+				delete obj;
+				return;
+			}
 
-			virtual List& ToList() { throw Error{ "Invalid cast" }; }
-			virtual Dict& ToDict() { throw Error{ "Invalid cast" }; }
+			obj->~T();
+			detail::Arena::Free(obj);
+		}
 
-			virtual Node& Get(std::size_t idx) { throw Error{ "Not a list" }; }
-			virtual Node& Get(const std::string& key) { throw Error{ "Not a dict" }; }
+		// Heap node taking over the value of an arena node, lists and dicts
+		// hand out their children this way since the caller may delete them
+		static Node* Evacuate(Node* node)
+		{
+			if (!node || !node->inArena)
+				return node;
 
-			virtual void Print(std::ostream& os, int indent = 0) { os << "Node{}"; }
-		};
+			Node* moved = new Node(node->type, node->val);
+			// a node owns nothing but its value
+			detail::Arena::Free(node);
+			return moved;
+		}
 
-		Type type;
-		Value* val;
+		// Values of the parser, built in arena if there is one
+		static Node NewScalar(detail::Arena* arena, Scalar&& text) { return { Type::SCALAR, Create<ValueScalar>(arena, std::move(text)) }; }
+		static Node* NewNode(detail::Arena* arena, Node&& node) { return Create<Node>(arena, std::move(node)); }
 
-		class ValueScalar : public Value
+		static Node NewList(detail::Arena* arena, List&& list)
 		{
-		public:
-			ValueScalar(const Scalar& _val) : val(_val) { }
+			auto value = Create<ValueList>(arena, std::move(list));
+			value->arenaChildren = arena != nullptr;
+			return { Type::LIST, value };
+		}
 
-			Value* Copy() { return new ValueScalar{ val }; }
+		static Node NewDict(detail::Arena* arena, Dict&& dict)
+		{
+			auto value = Create<ValueDict>(arena, std::move(dict));
+			value->arenaChildren = arena != nullptr;
+			return { Type::DICT, value };
+		}
 
-			bool ToBool() override
+		// Visits the paths in trie order so that only the keys after the prefix
+		// shared with the previous path are resolved. step returns the child for
+		// a key or nullptr, done receives the node for paths[idx].
+		template<class Step, class Done>
+		void WalkPaths(const std::vector<std::string>& paths, Step&& step, Done&& done)
+		{
+			std::vector<std::vector<std::string_view>> keys(paths.size());
+			std::vector<std::size_t> order(paths.size());
+
+			for (std::size_t i = 0; i < paths.size(); i++)
 			{
-				if (val == "true" || val == "yes")
-					return true;
-				else if (val == "false" || val == "no")
-					return false;
+				std::string_view path = paths[i];
+				std::size_t begin = 0;
+				while (true)
+				{
+					std::size_t end = path.find('.', begin);
+					keys[i].push_back(path.substr(begin, end - begin));
+					if (end == std::string_view::npos)
+						break;
+					begin = end + 1;
+				}
 
-				throw Error{ "Not a bool" };
+				order[i] = i;
 			}
 
-			double ToNumber() override
+			std::stable_sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) { return keys[a] < keys[b]; });
+
+			// stack[n] is the node after the first n keys of the previous path
+			std::vector<Node*> stack{ this };
+			const std::vector<std::string_view>* prev = nullptr;
+
+			for (std::size_t idx : order)
 			{
-				try
+				auto& curr = keys[idx];
+
+				std::size_t common = 0;
+				if (prev)
 				{
-					size_t idx;
-					double result = std::stod(val, &idx);
-					if (idx < val.size()) throw std::invalid_argument{ "" };
-					return result;
+					while (common < prev->size() && common < curr.size() && (*prev)[common] == curr[common])
+						common++;
 				}
-				catch (const std::invalid_argument&)
-				{
-					throw Error{ "Not a number" };
+
+				stack.resize(common + 1);
+				for (std::size_t i = common; i < curr.size(); i++)
+					stack.push_back(stack.back() ? step(*stack.back(), curr[i]) : nullptr);
+
+				done(idx, stack.back());
+				prev = &curr;
+			}
+		}
+
+		// The result of the lookup may be written to. Frozen values are left
+		// alone, lookups on them neither insert nor copy.
+		void UnshareForWrite()
+		{
+			if (IsShared() && !val->IsFrozen())
+				Unshare();
+		}
+
+		// Returns false if the hash can not be cached by the holder, a shared
+		// value does not tell its holders when it changes. Links and hashes are
+		// only stored if write is set.
+		static bool Fingerprint(const Node& node, uint64_t& hash, bool write)
+		{
+			if (node.IsList())
+				return Fingerprint(static_cast<ValueList*>(node.val), hash, "l", write);
+			if (node.IsDict())
+				return Fingerprint(static_cast<ValueDict*>(node.val), hash, "d", write);
+
+			if (node.IsScalar())
+			{
+				std::string_view str = node.ToStringView();
+				std::size_t size = str.size();
+				hash = detail::Hash({ reinterpret_cast<const char*>(&size), sizeof(size) }, detail::Hash("s"));
+				hash = detail::Hash(str, hash);
+			}
+			else
+				hash = detail::Hash("n");
+
+			return node.val->refs == 1;
+		}
+
+		template<class Container>
+		static bool Fingerprint(Container* value, uint64_t& hash, const char* tag, bool write)
+		{
+			// changes through a handed out container are not seen
+			bool cacheable = value->refs == 1 && !value->exposed;
+			if (cacheable && !value->stale)
+			{
+				hash = value->fingerprint;
+				return true;
+			}
+
+			// other holders of a shared value may read it on another thread, a
+			// frozen one is read only
+			write = write && value->refs == 1 && !value->frozen;
+			// without links a later change would not reach the holder
+			cacheable = cacheable && write;
+
+			hash = detail::Hash(tag);
+			for (auto& curr : value->val)
+			{
+				Node* child;
+				if constexpr (std::is_same_v<Container, ValueList>)
+					child = curr;
+				else
+					child = curr.second;
+
+				if (!child)
+				{
+					if constexpr (std::is_same_v<Container, ValueList>)
+						hash = detail::Hash("n", hash);
+					continue;
+				}
+
+				// linked like in Emitter::EmitCached, also for empty dict entries
+				// so that assigning them later drops the hash
+				if (write && !value->exposed && child->val->refs == 1)
+					child->val->parent = value;
+
+				if constexpr (std::is_same_v<Container, ValueDict>)
+				{
+					if (child->IsNone())
+						continue;
+
+					std::size_t size = curr.first.size();
+					hash = detail::Hash({ reinterpret_cast<const char*>(&size), sizeof(size) }, hash);
+					hash = detail::Hash(curr.first, hash);
+				}
+
+				uint64_t sub;
+				if (!Fingerprint(*child, sub, write))
+					cacheable = false;
+				hash = detail::Hash({ reinterpret_cast<const char*>(&sub), sizeof(sub) }, hash);
+			}
+			hash = detail::Hash("e", hash);
+
+			if (write && !value->exposed)
+				value->linked = true;
+			if (cacheable)
+			{
+				value->fingerprint = hash;
+				value->stale = false;
+			}
+
+			return cacheable;
+		}
+
+	private:
+		class Value
+		{
+		public:
+			virtual ~Value() = default;
+
+			virtual Value* Copy() { return new Value; }
+			// copy of this level only, the children are shared
+			virtual Value* Clone() { return Copy(); }
+			// deep copy into arena, see Compact()
+			virtual Value* CopyTo(detail::Arena& arena) { return Create<Value>(&arena); }
+
+			virtual bool ToBool() { throw Error{ "Invalid cast" }; }
+			virtual bool ToBool(bool def) { return def; }
+
+			virtual double ToNumber() { throw Error{ "Invalid cast" }; }
+			virtual double ToNumber(double def) { return def; }
+
+			virtual std::string ToString() { throw Error{ "Invalid cast" }; }
+			virtual std::string ToString(const std::string& def) { return def; }
+			virtual std::string_view ToStringView() { throw Error{ "Invalid cast" }; }
+			virtual detail::NativeScalar ToNative() { throw Error{ "Invalid cast" }; }
+
+			virtual List& ToList() { throw Error{ "Invalid cast" }; }
+			virtual Dict& ToDict() { throw Error{ "Invalid cast" }; }
+			virtual const List& ToList() const { throw Error{ "Invalid cast" }; }
+			virtual const Dict& ToDict() const { throw Error{ "Invalid cast" }; }
+
+			virtual Node* Find(const Key&) { return nullptr; }
+
+			virtual Node& Get(std::size_t) { throw Error{ "Not a list" }; }
+			virtual Node& Get(const std::string&) { throw Error{ "Not a dict" }; }
+			virtual Node& Get(const Key&) { throw Error{ "Not a dict" }; }
+
+			virtual void Freeze() { }
+			virtual bool IsFrozen() const { return false; }
+			virtual bool IsNative() const { return false; }
+
+			virtual void Print(std::ostream& os, int = 0) { os << "Node{}"; }
+
+			// Flags this value and its ancestors for Emitter::EmitCached and drops
+			// their fingerprints. A dirty or stale value only has dirty or stale
+			// ancestors respectively, so the walk stops at the first with both.
+			void MarkDirty()
+			{
+				for (Value* curr = this; curr && !(curr->dirty && curr->stale); curr = curr->parent)
+				{
+					curr->dirty = true;
+					curr->stale = true;
+				}
+			}
+
+			// set by Emitter::EmitCached and Fingerprint
+			Value* parent = nullptr;
+			bool dirty = true;
+			// fingerprint of a list or dict has to be computed again
+			bool stale = true;
+			// see Create()
+			bool inArena = false;
+
+			// nodes sharing this value, see Share(). Atomic since a snapshot may
+			// drop its reference on another thread.
+			std::atomic<uint32_t> refs{ 1 };
+		};
+
+		Type type;
+		// see Create()
+		bool inArena = false;
+		Value* val;
+
+		class ValueScalar : public Value
+		{
+		public:
+			ValueScalar(const Scalar& _val) : val(_val) { }
+			ValueScalar(Scalar&& _val) : val(std::move(_val)) { }
+
+			Value* Copy() { return new ValueScalar{ val }; }
+			Value* CopyTo(detail::Arena& arena) override { return Create<ValueScalar>(&arena, val); }
+
+			bool ToBool() override
+			{
+				if (val == "true" || val == "yes")
+					return true;
+				else if (val == "false" || val == "no")
+					return false;
+
+				throw Error{ "Not a bool" };
+			}
+
+			double ToNumber() override
+			{
+				try
+				{
+					size_t idx;
+					double result = std::stod(val, &idx);
+					if (idx < val.size()) throw std::invalid_argument{ "" };
+					return result;
+				}
+				catch (const std::invalid_argument&)
+				{
+					throw Error{ "Not a number" };
 				}
 			}
 
@@ -371,31 +1141,148 @@ namespace alt::config
 				return val;
 			}
 
-			bool ToBool(bool def) override { return ToBool(); }
-			double ToNumber(double def) override { return ToNumber(); }
-			std::string ToString(const std::string& def) override { return ToString(); }
+			std::string_view ToStringView() override
+			{
+				return val;
+			}
+
+			detail::NativeScalar ToNative() override
+			{
+				return detail::NativeScalar::Classify(val);
+			}
+
+			bool ToBool(bool) override { return ToBool(); }
+			double ToNumber(double) override { return ToNumber(); }
+			std::string ToString(const std::string&) override { return ToString(); }
 
 		private:
-			void Print(std::ostream& os, int indent = 0) override { os << val; }
+			void Print(std::ostream& os, int = 0) override { os << val; }
 
 		private:
 			Scalar val;
 		};
 
+		// Scalar built from a bool or number, the text is formatted on first use
+		class ValueNative : public Value
+		{
+		public:
+			ValueNative(bool _val) : kind(BOOL) { b = _val; }
+			ValueNative(int64_t _val) : kind(INT) { i = _val; }
+			ValueNative(double _val) : kind(DOUBLE) { d = _val; }
+
+			Value* Copy()
+			{
+				if (kind == BOOL)
+					return new ValueNative{ b };
+				else if (kind == INT)
+					return new ValueNative{ i };
+				return new ValueNative{ d };
+			}
+
+			Value* CopyTo(detail::Arena& arena) override
+			{
+				if (kind == BOOL)
+					return Create<ValueNative>(&arena, b);
+				else if (kind == INT)
+					return Create<ValueNative>(&arena, i);
+				return Create<ValueNative>(&arena, d);
+			}
+
+			bool ToBool() override
+			{
+				if (kind != BOOL)
+					throw Error{ "Not a bool" };
+				return b;
+			}
+
+			double ToNumber() override
+			{
+				if (kind == INT)
+					return static_cast<double>(i);
+				else if (kind == DOUBLE)
+					return d;
+
+				throw Error{ "Not a number" };
+			}
+
+			~ValueNative() override { delete text.load(std::memory_order_relaxed); }
+
+			std::string ToString() override
+			{
+				return std::string{ ToStringView() };
+			}
+
+			// Shared values may be read from several threads, the first one to
+			// publish the text wins
+			std::string_view ToStringView() override
+			{
+				std::string* curr = text.load(std::memory_order_acquire);
+				if (curr)
+					return *curr;
+
+				auto formatted = new std::string;
+				if (kind == BOOL)
+					*formatted = b ? "true" : "false";
+				else if (kind == INT)
+					*formatted = std::to_string(i);
+				else
+					*formatted = detail::FormatNumber(d);
+
+				if (text.compare_exchange_strong(curr, formatted, std::memory_order_acq_rel, std::memory_order_acquire))
+					return *formatted;
+
+				delete formatted;
+				return *curr;
+			}
+
+			detail::NativeScalar ToNative() override
+			{
+				if (kind == BOOL)
+					return detail::NativeScalar::FromBool(b);
+				else if (kind == INT)
+					return detail::NativeScalar::FromInt(i);
+				return detail::NativeScalar::FromDouble(d);
+			}
+
+			bool ToBool(bool) override { return ToBool(); }
+			double ToNumber(double) override { return ToNumber(); }
+			std::string ToString(const std::string&) override { return ToString(); }
+
+			bool IsNative() const override { return true; }
+
+		private:
+			void Print(std::ostream& os, int = 0) override { os << ToStringView(); }
+
+		private:
+			enum Kind : uint8_t
+			{
+				BOOL,
+				INT,
+				DOUBLE
+			} kind;
+
+			union
+			{
+				bool b;
+				int64_t i;
+				double d;
+			};
+
+			std::atomic<std::string*> text{ nullptr };
+		};
+
 		class ValueList : public Value
 		{
 		public:
 			ValueList(const List& _val) : val(_val) { }
+			ValueList(List&& _val) : val(std::move(_val)) { }
 			
 			ValueList() { }
 			
 			~ValueList() override
 			{
 				for (auto& curr : val)
-				{
-					if (!curr || curr->IsNone()) continue;
-					delete curr;
-				}
+					Destroy(curr);
 			}
 
 			Value* Copy()
@@ -409,11 +1296,60 @@ namespace alt::config
 				return newVal;
 			}
 
+			Value* CopyTo(detail::Arena& arena) override
+			{
+				auto newVal = Create<ValueList>(&arena);
+				newVal->arenaChildren = true;
+				newVal->val.reserve(val.size());
+				for (auto& curr : val)
+				{
+					if (!curr || curr->IsNone()) continue;
+					newVal->val.push_back(Create<Node>(&arena, curr->type, curr->val->CopyTo(arena)));
+				}
+				return newVal;
+			}
+
+			Value* Clone() override
+			{
+				auto newVal = new ValueList{};
+				for (auto& curr : val)
+				{
+					newVal->val.push_back(curr ? new Node(curr->Share()) : nullptr);
+				}
+				return newVal;
+			}
+
 			List& ToList() override
+			{
+				// the caller may modify the list
+				Unlink();
+				exposed = true;
+				frozen = false;
+				if (arenaChildren)
+				{
+					for (auto& curr : val)
+						curr = Evacuate(curr);
+					arenaChildren = false;
+				}
+				return val;
+			}
+
+			const List& ToList() const override
 			{
 				return val;
 			}
 
+			void Freeze() override
+			{
+				for (auto& curr : val)
+				{
+					if (curr) curr->Freeze();
+				}
+				frozen = true;
+			}
+
+			bool IsFrozen() const override { return frozen; }
+
 			Node& Get(std::size_t idx) override
 			{
 				static Node none;
@@ -430,23 +1366,48 @@ namespace alt::config
 			}
 
 		private:
+			friend class Node;
+			friend class Emitter;
+			friend class Parser;
+
+			// children may be moved elsewhere, stop them from dirtying this list
+			void Unlink()
+			{
+				MarkDirty();
+				if (!linked)
+					return;
+
+				for (auto& curr : val)
+				{
+					if (curr) curr->val->parent = nullptr;
+				}
+				linked = false;
+			}
+
 			List val;
+			bool frozen = false;
+			// children may be in an arena, see Evacuate()
+			bool arenaChildren = false;
+
+			// handed out by ToList(), from then on changes are not seen
+			bool exposed = false;
+			bool linked = false;
+
+			uint64_t fingerprint = 0;
 		};
 
 		class ValueDict : public Value
 		{
 		public:
 			ValueDict(const Dict& _val) : val(_val) { }
+			ValueDict(Dict&& _val) : val(std::move(_val)) { }
 			
 			ValueDict() { }
 			
 			~ValueDict() override
 			{
 				for (auto& curr : val)
-				{
-					if (!curr.second || curr.second->IsNone()) continue;
-					delete curr.second;
-				}
+					Destroy(curr.second);
 			}
 
 			Value* Copy()
@@ -460,59 +1421,326 @@ namespace alt::config
 				return newVal;
 			}
 
+			Value* CopyTo(detail::Arena& arena) override
+			{
+				auto newVal = Create<ValueDict>(&arena);
+				newVal->arenaChildren = true;
+				for (auto& curr : val)
+				{
+					if (!curr.second || curr.second->IsNone()) continue;
+					newVal->val.emplace_hint(newVal->val.end(), curr.first, Create<Node>(&arena, curr.second->type, curr.second->val->CopyTo(arena)));
+				}
+				return newVal;
+			}
+
+			Value* Clone() override
+			{
+				auto newVal = new ValueDict{};
+				for (auto& curr : val)
+				{
+					if (curr.second)
+						newVal->val.emplace_hint(newVal->val.end(), curr.first, new Node(curr.second->Share()));
+				}
+				return newVal;
+			}
+
 			Dict& ToDict() override
+			{
+				// the caller may modify the map
+				Unlink();
+				exposed = true;
+				PrepareWrite();
+				if (arenaChildren)
+				{
+					for (auto& curr : val)
+						curr.second = Evacuate(curr.second);
+					arenaChildren = false;
+				}
+				return val;
+			}
+
+			// Entry for key, nullptr if it was missing. Unlike ToDict() the other
+			// children stay where they are.
+			Node*& Slot(std::string_view key)
+			{
+				PrepareWrite();
+				auto result = val.find(key);
+				if (result == val.end())
+					result = val.emplace(std::string{ key }, nullptr).first;
+				return result->second;
+			}
+
+			const Dict& ToDict() const override
 			{
 				return val;
 			}
 
+			void Freeze() override
+			{
+				for (auto& curr : val)
+				{
+					if (curr.second) curr.second->Freeze();
+				}
+
+				frozen = true;
+				index.clear();
+				if (val.size() >= INDEX_THRESHOLD)
+					BuildPerfect();
+			}
+
+			bool IsFrozen() const override { return frozen; }
+
 			Node& Get(const std::string& key) override
 			{
+				if (frozen)
+				{
+					// a shared empty node could be written to
+					Node* result = perfect.empty() ? FindInMap(key) : Probe(detail::Hash(key), key);
+					if (!result)
+						throw Error{ "Missing key in frozen dict: " + key };
+					return *result;
+				}
+
 				auto result = val.find(key);
 				if (result == val.end())
 				{
 					auto newNode = new Node();
 					val[key] = newNode;
+					index.clear();
+					MarkDirty();
 					return *newNode;
 				}
 				return *result->second;
 			}
 
-		private:
-			Dict val;
-		};
-	};
-
-	class Parser
-	{
-	public:
-		Parser(std::istream& is) :
-			buffer{ (std::istreambuf_iterator<char>(is)),
-				std::istreambuf_iterator<char>() }
-		{
+			Node& Get(const Key& key) override
+			{
+				if (Node* result = Find(key))
+					return *result;
 
-		}
+				return Get(std::string{ key.String() });
+			}
 
-		Parser(const std::vector<char>& _buffer) :
-			buffer(_buffer)
-		{
+			Node* Find(const Key& key) override
+			{
+				if (frozen && !perfect.empty())
+					return Probe(key.Hash(), key.String());
 
-		}
+				if (frozen || val.size() < INDEX_THRESHOLD)
+					return FindInMap(key.String());
 
-		Parser(const char* data, size_t size) :
-			buffer(data, data + size)
-		{
+				if (index.empty())
+					BuildIndex();
 
-		}
+				std::size_t mask = index.size() - 1;
+				for (std::size_t i = key.Hash() & mask; index[i].key; i = (i + 1) & mask)
+				{
+					if (index[i].hash == key.Hash() && *index[i].key == key.String())
+						return index[i].node;
+				}
 
-		Node Parse()
-		{
-			FixEncoding();
-			Tokenize();
-			auto begin = tokens.begin();
-			return Parse(begin);
-		}
+				return nullptr;
+			}
 
-	private:
+		private:
+			static constexpr std::size_t INDEX_THRESHOLD = 8;
+
+			struct IndexSlot
+			{
+				uint64_t hash;
+				const std::string* key;
+				Node* node;
+			};
+
+			void PrepareWrite()
+			{
+				MarkDirty();
+				index.clear();
+				if (frozen)
+				{
+					frozen = false;
+					perfect.clear();
+					seeds.clear();
+				}
+			}
+
+			// open addressing table over the map, at most half full
+			void BuildIndex()
+			{
+				std::size_t capacity = 16;
+				while (capacity < val.size() * 2)
+					capacity <<= 1;
+
+				index.assign(capacity, { 0, nullptr, nullptr });
+
+				for (auto& curr : val)
+				{
+					uint64_t hash = detail::Hash(curr.first);
+					std::size_t i = hash & (capacity - 1);
+					while (index[i].key)
+						i = (i + 1) & (capacity - 1);
+					index[i] = { hash, &curr.first, curr.second };
+				}
+			}
+
+			static uint64_t Mix(uint64_t hash, uint32_t seed)
+			{
+				hash ^= seed * 0x9E3779B97F4A7C15ull;
+				hash ^= hash >> 33;
+				hash *= 0xFF51AFD7ED558CCDull;
+				hash ^= hash >> 33;
+				hash *= 0xC4CEB9FE1A85EC53ull;
+				hash ^= hash >> 33;
+				return hash;
+			}
+
+			Node* FindInMap(std::string_view key)
+			{
+				auto result = val.find(key);
+				return result == val.end() ? nullptr : result->second;
+			}
+
+			Node* Probe(uint64_t hash, std::string_view key)
+			{
+				uint32_t seed = seeds[hash % seeds.size()];
+				auto& slot = perfect[seed & DIRECT ? seed & ~DIRECT : Mix(hash, seed) % perfect.size()];
+
+				if (slot.hash != hash || *slot.key != key)
+					return nullptr;
+				return slot.node;
+			}
+
+			// Hash and displace: keys are split into buckets of ~4, then starting
+			// with the largest bucket a seed is searched that moves all of its keys
+			// into free slots. Single key buckets store their slot directly.
+			void BuildPerfect()
+			{
+				std::size_t n = val.size();
+				std::vector<std::vector<IndexSlot>> buckets((n + 3) / 4);
+
+				for (auto& curr : val)
+				{
+					uint64_t hash = detail::Hash(curr.first);
+					buckets[hash % buckets.size()].push_back({ hash, &curr.first, curr.second });
+				}
+
+				std::vector<std::size_t> order(buckets.size());
+				for (std::size_t i = 0; i < order.size(); i++)
+					order[i] = i;
+				std::stable_sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) {
+					return buckets[a].size() > buckets[b].size();
+				});
+
+				perfect.assign(n, { 0, nullptr, nullptr });
+				seeds.assign(buckets.size(), 0);
+
+				std::vector<std::size_t> taken;
+				std::size_t nextFree = 0;
+
+				for (auto b : order)
+				{
+					auto& bucket = buckets[b];
+					if (bucket.empty())
+						break;
+
+					if (bucket.size() == 1)
+					{
+						while (perfect[nextFree].key)
+							nextFree++;
+
+						perfect[nextFree] = bucket[0];
+						seeds[b] = DIRECT | static_cast<uint32_t>(nextFree);
+						continue;
+					}
+
+					uint32_t seed = 1;
+					for (; seed < MAX_SEED; seed++)
+					{
+						taken.clear();
+						for (auto& entry : bucket)
+						{
+							std::size_t slot = Mix(entry.hash, seed) % n;
+							if (perfect[slot].key || std::find(taken.begin(), taken.end(), slot) != taken.end())
+								break;
+							taken.push_back(slot);
+						}
+
+						if (taken.size() == bucket.size())
+							break;
+					}
+
+					// only happens for colliding hashes, fall back to the map
+					if (seed == MAX_SEED)
+					{
+						perfect.clear();
+						seeds.clear();
+						return;
+					}
+
+					for (std::size_t i = 0; i < bucket.size(); i++)
+						perfect[taken[i]] = bucket[i];
+					seeds[b] = seed;
+				}
+			}
+
+			static constexpr uint32_t DIRECT = 0x80000000u;
+			static constexpr uint32_t MAX_SEED = 1u << 16;
+
+			friend class Node;
+			friend class Emitter;
+			friend class Parser;
+
+			void Unlink()
+			{
+				MarkDirty();
+				if (!linked)
+					return;
+
+				for (auto& curr : val)
+				{
+					if (curr.second) curr.second->val->parent = nullptr;
+				}
+				linked = false;
+			}
+
+			Dict val;
+			std::vector<IndexSlot> index;
+			// children may be in an arena, see Evacuate()
+			bool arenaChildren = false;
+
+			bool frozen = false;
+			std::vector<IndexSlot> perfect;
+			std::vector<uint32_t> seeds;
+
+			// handed out by ToDict(), from then on changes are not seen
+			bool exposed = false;
+			bool linked = false;
+
+			// text of the entries, kept by Emitter::EmitCached
+			struct Emitted
+			{
+				std::string key;
+				const Value* value;
+				bool isLast;
+				std::string text;
+			};
+			std::vector<Emitted> emitted;
+
+			uint64_t fingerprint = 0;
+		};
+	};
+
+	// Syntax that changes the meaning of existing documents, off unless
+	// requested from Parser, BatchParser, Reader or Lexer
+	enum ParseFlags : uint32_t
+	{
+		PARSE_DEFAULT = 0,
+		// &name in front of a value and *name sharing it, see Node::Share()
+		PARSE_ANCHORS = 1 << 0,
+	};
+
+	namespace detail
+	{
 		struct Token
 		{
 			enum Type
@@ -524,113 +1752,175 @@ namespace alt::config
 				DICT_END,
 
 				KEY,
-				SCALAR
+				SCALAR,
+				// *name, value is the name
+				ALIAS
 			} type;
 
 			std::string value;
 			size_t pos;
 			size_t line;
 			size_t col;
+			// &name in front of a scalar, list or dict
+			std::string anchor;
 		};
 
-		std::size_t Unread() { return buffer.size() - readPos; }
-		char Peek(std::size_t offset = 0) { return *(buffer.data() + readPos + offset); }
-		char Get()
+		inline bool IsAnchorChar(char c)
 		{
-			column++;
-			if (Peek() == '\n')
-			{
-				line++;
-				column = 0;
-			}
-			return *(buffer.data() + readPos++);
+			return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_' || c == '-';
+		}
+
+		inline bool IsAlias(std::string_view val)
+		{
+			return val.size() > 1 && val[0] == '*' && std::all_of(val.begin() + 1, val.end(), IsAnchorChar);
 		}
-		void Skip(std::size_t n = 1)
+
+		class BufferSource
 		{
-			for (int i = 0; i < n; i++)
+		public:
+			BufferSource(const char* _data, std::size_t _size) :
+				data(_data),
+				size(_size)
 			{
-				column++;
-				if (Peek(i) == '\n')
-				{
-					line++;
-					column = 0;
-				}
+
 			}
-			readPos += n;
-		}
 
-		void SkipToNextToken()
+			std::size_t Unread() { return size - readPos; }
+			char Peek(std::size_t offset = 0) { return readPos + offset < size ? data[readPos + offset] : '\0'; }
+			void Advance(std::size_t n = 1) { readPos += n; }
+			std::size_t Position() const { return readPos; }
+
+		private:
+			const char* data;
+			std::size_t size;
+			std::size_t readPos = 0;
+		};
+
+		// Reads the input in fixed-size chunks, only the unread tail of the
+		// current chunk is kept around.
+		class StreamSource
 		{
-			while (Unread() > 0)
+		public:
+			StreamSource(std::istream& _is, std::size_t _chunkSize = 64 * 1024) :
+				is(_is),
+				chunkSize(std::max<std::size_t>(_chunkSize, 4))
 			{
-				if (Peek() == ' ' || Peek() == '\n' || Peek() == '\r' || Peek() == '\t' || Peek() == ',')
-					Skip();
-				else if (Peek() == '#')
-				{
-					Skip();
+				// skip BOM header
+				Fill(3);
+				if (window.size() >= 3 && window[0] == (char)0xEF && window[1] == (char)0xBB && window[2] == (char)0xBF)
+					readPos = 3;
+			}
 
-					while (Unread() > 0 && Peek() != '\n' && Peek() != '#' && Peek() != '"')
-						Skip();
+			std::size_t Unread() { Fill(2); return window.size() - readPos; }
+			char Peek(std::size_t offset = 0)
+			{
+				Fill(offset + 1);
+				return readPos + offset < window.size() ? window[readPos + offset] : '\0';
+			}
+			void Advance(std::size_t n = 1) { readPos += n; consumed += n; }
+			std::size_t Position() const { return consumed; }
 
-					if (Peek() == '"') {
-						Skip();
-						while (Unread() > 0 && Peek() != '\n' && Peek() != '"')
-							Skip();
-					}
+		private:
+			void Fill(std::size_t n)
+			{
+				if (window.size() - readPos >= n || eof)
+					return;
+
+				window.erase(window.begin(), window.begin() + readPos);
+				readPos = 0;
 
-					if (Unread() > 0) Skip();
+				while (window.size() < n && !eof)
+				{
+					std::size_t filled = window.size();
+					window.resize(filled + chunkSize);
+					is.read(window.data() + filled, chunkSize);
+					window.resize(filled + static_cast<std::size_t>(is.gcount()));
+					eof = !is;
 				}
-				else
-					break;
 			}
-		}
 
-		void Tokenize()
+			std::istream& is;
+			std::size_t chunkSize;
+			std::vector<char> window;
+			std::size_t readPos = 0;
+			std::size_t consumed = 0;
+			bool eof = false;
+		};
+
+		// Produces one token at a time, wrapping the document into the implicit
+		// top level DICT_START/DICT_END pair.
+		template<class Source>
+		class Scanner
 		{
-			tokens.push_back({ Token::DICT_START, "", 0 });
+		public:
+			template<class... Args>
+			Scanner(Args&&... args) :
+				src(std::forward<Args>(args)...)
+			{
 
-			while (Unread() > 0)
+			}
+
+			// &name and *name, see PARSE_ANCHORS
+			void SetAnchors(bool enable) { anchors = enable; }
+
+			bool Next(Token& tok)
 			{
+				if (state == State::BEGIN)
+				{
+					state = State::BODY;
+					tok = { Token::DICT_START, "", 0, 0, 0, "" };
+					return true;
+				}
+
+				if (state == State::END)
+					return false;
+
 				SkipToNextToken();
+				start = src.Position();
 
-				if (Unread() == 0)
-					break;
+				if (src.Unread() == 0)
+				{
+					state = State::END;
+					tok = { Token::DICT_END, "", src.Position(), this->line, this->column, "" };
+					return true;
+				}
 
-				if (Peek() == '[')
+				if (src.Peek() == '[')
 				{
 					Skip();
-					tokens.push_back({ Token::ARRAY_START, "", this->readPos, this->line, this->column });
+					tok = { Token::ARRAY_START, "", src.Position(), this->line, this->column, "" };
 				}
-				else if (Peek() == ']')
+				else if (src.Peek() == ']')
 				{
 					Skip();
-					tokens.push_back({ Token::ARRAY_END, "", this->readPos, this->line, this->column });
+					tok = { Token::ARRAY_END, "", src.Position(), this->line, this->column, "" };
 				}
-				else if (Peek() == '{')
+				else if (src.Peek() == '{')
 				{
 					Skip();
-					tokens.push_back({ Token::DICT_START, "", this->readPos, this->line, this->column });
+					tok = { Token::DICT_START, "", src.Position(), this->line, this->column, "" };
 				}
-				else if (Peek() == '}')
+				else if (src.Peek() == '}')
 				{
 					Skip();
-					tokens.push_back({ Token::DICT_END, "", this->readPos, this->line, this->column });
+					tok = { Token::DICT_END, "", src.Position(), this->line, this->column, "" };
 				}
 				else
 				{
 					std::string val;
+					bool quoted = true;
 
-					if (Peek() == '\'' || Peek() == '"')
+					if (src.Peek() == '\'' || src.Peek() == '"')
 					{
 						char start = Get();
 
-						if (Peek() != start)
+						if (src.Peek() != start)
 						{
-							while (Unread() > 1 && (Peek() == '\\' || Peek(1) != start))
+							while (src.Unread() > 1 && (src.Peek() == '\\' || src.Peek(1) != start))
 							{
-								if (Peek() == '\n' || Peek() == '\r')
+								if (src.Peek() == '\n' || src.Peek() == '\r')
 								{
-									if (Get() == '\r' && Peek() == '\n')
+									if (Get() == '\r' && src.Peek() == '\n')
 										Skip();
 
 									val += '\n';
@@ -640,143 +1930,1370 @@ namespace alt::config
 								val += Get();
 							}
 
-							if (Unread() > 0)
+							if (src.Unread() > 0)
 								val += Get();
 
-							if (Unread() == 0)
-								throw Error("Unexpected end of file", this->readPos, this->line, this->column);
+							if (src.Unread() == 0)
+								throw Error("Unexpected end of file", src.Position(), this->line, this->column);
 						}
 
 						Skip();
+						end = src.Position();
 					}
 					else
 					{
-						while (Unread() > 0 &&
-							Peek() != '\n' &&
-							Peek() != ':' &&
-							Peek() != ',' &&
-							Peek() != ']' &&
-							Peek() != '}' &&
-							Peek() != '#')
+						if (anchors && src.Peek() == '&' && src.Unread() > 1 && IsAnchorChar(src.Peek(1)))
 						{
 							val += Get();
+							while (src.Unread() > 0 && IsAnchorChar(src.Peek()))
+								val += Get();
+
+							// otherwise just a scalar starting with &
+							if (src.Unread() > 0 && (src.Peek() == ' ' || src.Peek() == '\t' || src.Peek() == '\n' || src.Peek() == '\r'))
+								return NextAnchored(tok, val.substr(1));
+						}
+
+						quoted = false;
+						end = src.Position();
+						while (src.Unread() > 0 &&
+							src.Peek() != '\n' &&
+							src.Peek() != ':' &&
+							src.Peek() != ',' &&
+							src.Peek() != ']' &&
+							src.Peek() != '}' &&
+							src.Peek() != '#')
+						{
+							char c = Get();
+							val += c;
+							if (c != ' ' && c != '\t' && c != '\r')
+								end = src.Position();
 						}
 					}
 
-					val = detail::Unescape(val);
+					// escape sequences never form an alias
+					bool alias = anchors && !quoted && val.find('\\') == std::string::npos;
+					val = Unescape(val);
 
-					if (Unread() > 0 && Peek() == ':')
-						tokens.push_back({ Token::KEY, val, this->readPos, this->line, this->column });
+					if (src.Unread() > 0 && src.Peek() == ':')
+						tok = { Token::KEY, std::move(val), src.Position(), this->line, this->column, "" };
+					else if (alias && IsAlias(val))
+						tok = { Token::ALIAS, val.substr(1), src.Position(), this->line, this->column, "" };
 					else
-						tokens.push_back({ Token::SCALAR, val, this->readPos, this->line, this->column });
+						tok = { Token::SCALAR, std::move(val), src.Position(), this->line, this->column, "" };
 
-					if (Unread() > 0 && (Peek() == ':' || Peek() == ','))
+					if (src.Unread() > 0 && (src.Peek() == ':' || src.Peek() == ','))
 						Skip();
 				}
+
+				return true;
 			}
 
-			tokens.push_back({ Token::DICT_END, "", this->readPos, this->line, this->column });
-		}
+			Source& GetSource() { return src; }
 
-		Node Parse(std::deque<Token>::iterator& tok)
-		{
-			switch (tok->type)
-			{
-			case Token::SCALAR:
-				return { (tok++)->value };
-			case Token::ARRAY_START:
+			// Offset of the first character of the last token
+			std::size_t TokenStart() const { return start; }
+			// Offset past the last key, scalar or alias without trailing blanks
+			std::size_t TokenEnd() const { return end; }
+
+		private:
+			bool NextAnchored(Token& tok, std::string&& anchor)
 			{
-				Node::List list;
+				Next(tok);
 
-				++tok;
-				while (tok != tokens.end() && tok->type != Token::ARRAY_END)
-					list.push_back(new Node(Parse(tok)));
+				bool isValue = tok.type == Token::SCALAR || tok.type == Token::ARRAY_START || tok.type == Token::DICT_START;
+				if (!isValue || !tok.anchor.empty())
+					throw Error("Anchor without a value", tok.pos, tok.line, tok.col);
 
-				++tok;
-				return { list };
+				tok.anchor = std::move(anchor);
+				return true;
 			}
-			case Token::DICT_START:
+
+			enum class State
+			{
+				BEGIN,
+				BODY,
+				END,
+			};
+
+			char Get()
+			{
+				char c = src.Peek();
+				Skip();
+				return c;
+			}
+			void Skip(std::size_t n = 1)
 			{
-				Node::Dict dict;
+				for (std::size_t i = 0; i < n; i++)
+				{
+					column++;
+					if (src.Peek(i) == '\n')
+					{
+						line++;
+						column = 0;
+					}
+				}
+				src.Advance(n);
+			}
 
-				++tok;
-				while (tok != tokens.end() && tok->type != Token::DICT_END)
+			void SkipToNextToken()
+			{
+				while (src.Unread() > 0)
 				{
-					if (tok->type != Token::KEY)
-						throw Error("key expected", tok->pos, tok->line, tok->col);
+					if (src.Peek() == ' ' || src.Peek() == '\n' || src.Peek() == '\r' || src.Peek() == '\t' || src.Peek() == ',')
+						Skip();
+					else if (src.Peek() == '#')
+					{
+						Skip();
 
-					std::string key = tok->value;
+						while (src.Unread() > 0 && src.Peek() != '\n' && src.Peek() != '#' && src.Peek() != '"')
+							Skip();
 
-					dict.insert({ key, new Node(Parse(++tok)) });
-				}
+						if (src.Peek() == '"') {
+							Skip();
+							while (src.Unread() > 0 && src.Peek() != '\n' && src.Peek() != '"')
+								Skip();
+						}
 
-				++tok;
-				return { dict };
-			}
+						if (src.Unread() > 0) Skip();
+					}
+					else
+						break;
+				}
 			}
 
-			throw Error("Unexpected character", tok->pos, tok->line, tok->col);
-		}
+			Source src;
+			bool anchors = false;
+			State state = State::BEGIN;
+			std::size_t start = 0;
+			std::size_t end = 0;
+			std::size_t line = 1;
+			std::size_t column = 0;
+		};
+	}
 
-		void FixEncoding()
+	// Tokenizes a buffer in place. Tokens only reference the source by offset
+	// so they can be stored contiguously and cheaply re-created after an edit.
+	// The buffer is not copied and has to outlive the lexer.
+	class Lexer
+	{
+	public:
+		struct Token
 		{
-			if(buffer.size() < 3) return;
-			// If file is encoded with BOM, remove the BOM header from the buffer
-			if(buffer[0] == (char)0xEF && buffer[1] == (char)0xBB && buffer[2] == (char)0xBF)
+			enum Kind : uint8_t
 			{
-				buffer.erase(buffer.begin(), buffer.begin() + 3);
-			}
+				ARRAY_START,
+				ARRAY_END,
+
+				DICT_START,
+				DICT_END,
+
+				KEY,
+				SCALAR,
+
+				// &name and *name with PARSE_ANCHORS, Raw() and Value() return
+				// the name
+				ANCHOR,
+				ALIAS
+			};
+
+			uint32_t offset;
+			uint32_t length;
+			Kind kind;
+			// the value differs from the raw text and has to go through Value()
+			bool escaped;
+			// offset and length include the quotes
+			bool quoted;
+		};
+
+		Lexer(const char* _data, std::size_t _size, uint32_t flags = PARSE_DEFAULT) :
+			data(_data),
+			size(_size),
+			readPos(Start()),
+			anchors(flags & PARSE_ANCHORS)
+		{
+
 		}
 
-		std::vector<char> buffer;
-		std::size_t readPos = 0;
-		std::size_t line = 1;
-		std::size_t column = 0;
-		std::deque<Token> tokens;
-	};
+		const std::vector<Token>& Lex()
+		{
+			tokens.clear();
+			readPos = Start();
 
-	class Emitter
-	{
-	public:
-		static void Emit(Node& node, std::ostream& os, int indent = 0, bool isLast = true)
+			Token tok;
+			while (Next(tok))
+				tokens.push_back(tok);
+
+			return tokens;
+		}
+
+		// Re-lexes the buffer after its contents changed starting at `offset`,
+		// tokens in front of the change are kept.
+		const std::vector<Token>& Relex(const char* _data, std::size_t _size, std::size_t offset)
 		{
-			std::string _indent(indent * 2, ' ');
+			data = _data;
+			size = _size;
 
-			if (node.IsScalar())
+			auto it = std::lower_bound(tokens.begin(), tokens.end(), offset, [](const Token& tok, std::size_t off) {
+				return tok.offset < off;
+			});
+
+			// the token in front of the change may be terminated differently now
+			if (it != tokens.begin())
 			{
-				os << '\'' << detail::Escape(node.ToString()) << "'\n";
+				--it;
+				readPos = it->offset;
 			}
-			else if (node.IsList())
-			{
-				os << "[\n";
+			else
+				readPos = Start();
 
-				auto& list = node.ToList();
-				for (auto it = list.begin(); it != list.end(); ++it)
-				{
-					os << _indent;
-					Emit(**it, os, indent + 1, std::next(it) == list.end());
-				}
+			tokens.erase(it, tokens.end());
 
-				os << std::string((indent - 1) * 2, ' ') << (isLast ? "]\n" : "],\n");
-			}
-			else if (node.IsDict())
-			{
-				if (indent > 0)
-					os << "{\n";
+			Token tok;
+			while (Next(tok))
+				tokens.push_back(tok);
 
-				auto& dict = node.ToDict();
-				for (auto it = dict.begin(); it != dict.end(); ++it)
-				{
-					if (!it->second || it->second->IsNone())
-						continue;
+			return tokens;
+		}
 
-					os << _indent << it->first << ": ";
-					Emit(*it->second, os, indent + 1, std::next(it) == dict.end());
-				}
+		bool Next(Token& tok)
+		{
+			SkipToNextToken();
 
-				if (indent > 0)
-					os << std::string((indent-1) * 2, ' ') << (isLast ? "}\n" : "},\n");
-			}
+			if (readPos >= size)
+				return false;
+
+			tok.offset = static_cast<uint32_t>(readPos);
+			tok.escaped = false;
+			tok.quoted = false;
+
+			switch (data[readPos])
+			{
+			case '[':
+				tok.kind = Token::ARRAY_START;
+				break;
+			case ']':
+				tok.kind = Token::ARRAY_END;
+				break;
+			case '{':
+				tok.kind = Token::DICT_START;
+				break;
+			case '}':
+				tok.kind = Token::DICT_END;
+				break;
+			default:
+				LexScalar(tok);
+				return true;
+			}
+
+			tok.length = 1;
+			readPos++;
+			return true;
+		}
+
+		std::string_view Raw(const Token& tok) const
+		{
+			if (tok.quoted)
+				return { data + tok.offset + 1, tok.length - 2u };
+			if (tok.kind == Token::ANCHOR || tok.kind == Token::ALIAS)
+				return { data + tok.offset + 1, tok.length - 1u };
+			return { data + tok.offset, tok.length };
+		}
+
+		std::string Value(const Token& tok) const
+		{
+			auto raw = Raw(tok);
+			if (!tok.escaped)
+				return std::string{ raw };
+
+			if (!tok.quoted)
+				return detail::Unescape(std::string{ raw });
+
+			// line breaks are normalized, except for the last character which
+			// the scanner takes as is
+			std::string val;
+			val.reserve(raw.size());
+			for (std::size_t i = 0; i + 1 < raw.size(); i++)
+			{
+				if (raw[i] == '\r')
+				{
+					if (i + 2 < raw.size() && raw[i + 1] == '\n')
+						i++;
+					val += '\n';
+					continue;
+				}
+				val += raw[i];
+			}
+			if (!raw.empty())
+				val += raw.back();
+
+			return detail::Unescape(val);
+		}
+
+		void Locate(std::size_t offset, std::size_t& line, std::size_t& column) const
+		{
+			line = 1;
+			column = 0;
+			for (std::size_t i = 0; i < offset && i < size; i++)
+			{
+				column++;
+				if (data[i] == '\n')
+				{
+					line++;
+					column = 0;
+				}
+			}
+		}
+
+		const std::vector<Token>& GetTokens() const { return tokens; }
+
+	private:
+		std::size_t Start() const
+		{
+			// skip BOM header
+			if (size >= 3 && data[0] == (char)0xEF && data[1] == (char)0xBB && data[2] == (char)0xBF)
+				return 3;
+			return 0;
+		}
+
+		std::size_t Unread() const { return size - readPos; }
+		char Peek(std::size_t offset = 0) const { return readPos + offset < size ? data[readPos + offset] : '\0'; }
+
+		static bool IsSpace(char c) { return c >= 0 && std::isspace(c); }
+
+		void SkipToNextToken()
+		{
+			while (Unread() > 0)
+			{
+				if (Peek() == ' ' || Peek() == '\n' || Peek() == '\r' || Peek() == '\t' || Peek() == ',')
+					readPos++;
+				else if (Peek() == '#')
+				{
+					readPos++;
+
+					while (Unread() > 0 && Peek() != '\n' && Peek() != '#' && Peek() != '"')
+						readPos++;
+
+					if (Peek() == '"') {
+						readPos++;
+						while (Unread() > 0 && Peek() != '\n' && Peek() != '"')
+							readPos++;
+					}
+
+					if (Unread() > 0) readPos++;
+				}
+				else
+					break;
+			}
+		}
+
+		// Follows the scalar rules of the Parser, see detail::Scanner
+		void LexScalar(Token& tok)
+		{
+			if (Peek() == '\'' || Peek() == '"')
+			{
+				char start = data[readPos++];
+				tok.quoted = true;
+
+				if (Peek() != start)
+				{
+					while (Unread() > 1 && (Peek() == '\\' || Peek(1) != start))
+					{
+						if (Peek() == '\r')
+						{
+							tok.escaped = true;
+							readPos += Peek(1) == '\n' ? 2 : 1;
+							continue;
+						}
+
+						if (Peek() == '\\')
+							tok.escaped = true;
+						readPos++;
+					}
+
+					if (Unread() > 0)
+					{
+						if (Peek() == '\\' || Peek() == '\r' || IsSpace(Peek()))
+							tok.escaped = true;
+						readPos++;
+					}
+
+					if (Unread() == 0)
+					{
+						std::size_t line, column;
+						Locate(readPos, line, column);
+						throw Error("Unexpected end of file", readPos, line, column);
+					}
+				}
+
+				readPos++;
+				tok.length = static_cast<uint32_t>(readPos - tok.offset);
+			}
+			else
+			{
+				if (anchors && Peek() == '&' && detail::IsAnchorChar(Peek(1)))
+				{
+					std::size_t end = readPos + 1;
+					while (end < size && detail::IsAnchorChar(data[end]))
+						end++;
+
+					if (end < size && (data[end] == ' ' || data[end] == '\t' || data[end] == '\n' || data[end] == '\r'))
+					{
+						tok.kind = Token::ANCHOR;
+						tok.length = static_cast<uint32_t>(end - tok.offset);
+						readPos = end;
+						return;
+					}
+				}
+
+				while (Unread() > 0 &&
+					Peek() != '\n' &&
+					Peek() != ':' &&
+					Peek() != ',' &&
+					Peek() != ']' &&
+					Peek() != '}' &&
+					Peek() != '#')
+				{
+					if (Peek() == '\\')
+						tok.escaped = true;
+					readPos++;
+				}
+
+				// trailing spaces are not part of the value
+				std::size_t end = readPos;
+				while (end > tok.offset && IsSpace(data[end - 1]))
+					end--;
+				tok.length = static_cast<uint32_t>(end - tok.offset);
+			}
+
+			if (Unread() > 0 && Peek() == ':')
+				tok.kind = Token::KEY;
+			else
+			{
+				tok.kind = Token::SCALAR;
+				if (anchors && !tok.quoted && !tok.escaped && detail::IsAlias(Raw(tok)))
+					tok.kind = Token::ALIAS;
+			}
+
+			if (Unread() > 0 && (Peek() == ':' || Peek() == ','))
+				readPos++;
+		}
+
+		const char* data;
+		std::size_t size;
+		std::size_t readPos;
+		std::vector<Token> tokens;
+		bool anchors;
+	};
+
+	// Source ranges of parsed nodes, filled by Parser::Parse(SourceMap&).
+	// Offsets are stored delta encoded, line and column are computed on demand.
+	// Entries follow the node when it is moved, but not when it is reassigned
+	// or compacted. An alias shares the value of its anchor, so its own range
+	// is kept by the address of its node inside the parent and is lost if the
+	// node is moved elsewhere, the anchor's range is found then.
+	class SourceMap
+	{
+	public:
+		struct Range
+		{
+			std::size_t begin;
+			std::size_t end;
+		};
+
+		bool Find(const Node& node, Range& range) const
+		{
+			return Lookup(aliases, &node, range) || Lookup(index, node.val, range);
+		}
+
+		// Same convention as the parser errors: lines start at 1, columns at 0
+		void Locate(std::size_t offset, std::size_t& line, std::size_t& column) const
+		{
+			auto it = std::upper_bound(lines.begin(), lines.end(), offset);
+			line = it - lines.begin();
+			column = line > 0 ? offset - lines[line - 1] : offset;
+		}
+
+		std::size_t Size() const { return index.size() + aliases.size(); }
+
+		void Clear()
+		{
+			deltas.clear();
+			checkpoints.clear();
+			index.clear();
+			aliases.clear();
+			lines.clear();
+			last = 0;
+			base = 0;
+		}
+
+	private:
+		friend class Parser;
+
+		static constexpr std::size_t CHECKPOINT = 32;
+
+		using Index = std::vector<std::pair<const void*, uint32_t>>;
+
+		bool Lookup(const Index& keys, const void* key, Range& range) const
+		{
+			auto it = std::lower_bound(keys.begin(), keys.end(), std::make_pair(key, uint32_t{ 0 }));
+			if (it == keys.end() || it->first != key)
+				return false;
+
+			range = Decode(it->second);
+			return true;
+		}
+
+		void Add(const Node& node, std::size_t begin, std::size_t end) { Add(index, node.val, begin, end); }
+
+		// node has to be at its final place in the parent
+		void AddAlias(const Node& node, std::size_t begin, std::size_t end) { Add(aliases, &node, begin, end); }
+
+		void Add(Index& keys, const void* key, std::size_t begin, std::size_t end)
+		{
+			uint32_t id = static_cast<uint32_t>(Size());
+			if (id % CHECKPOINT == 0)
+				checkpoints.push_back({ deltas.size(), last });
+
+			// nodes are added when they are complete, so begin is not monotonic
+			int64_t delta = static_cast<int64_t>(begin) - static_cast<int64_t>(last);
+			Write((static_cast<uint64_t>(delta) << 1) ^ static_cast<uint64_t>(delta >> 63));
+			Write(end - begin);
+			last = begin;
+
+			keys.push_back({ key, id });
+		}
+
+		void Finish(const std::vector<char>& buffer, std::size_t _base)
+		{
+			base = _base;
+			std::sort(index.begin(), index.end());
+			std::sort(aliases.begin(), aliases.end());
+
+			lines.push_back(0);
+			for (std::size_t i = 0; i < buffer.size(); i++)
+			{
+				if (buffer[i] == '\n')
+					lines.push_back(base + i + 1);
+			}
+		}
+
+		Range Decode(uint32_t id) const
+		{
+			auto& checkpoint = checkpoints[id / CHECKPOINT];
+			std::size_t pos = checkpoint.first;
+			std::size_t begin = checkpoint.second;
+			std::size_t length = 0;
+
+			for (uint32_t i = id - id % CHECKPOINT; i <= id; i++)
+			{
+				uint64_t zigzag = Read(pos);
+				begin += static_cast<std::size_t>(static_cast<int64_t>(zigzag >> 1) ^ -static_cast<int64_t>(zigzag & 1));
+				length = static_cast<std::size_t>(Read(pos));
+			}
+
+			return { base + begin, base + begin + length };
+		}
+
+		void Write(uint64_t val)
+		{
+			while (val >= 0x80)
+			{
+				deltas.push_back(static_cast<uint8_t>(val | 0x80));
+				val >>= 7;
+			}
+			deltas.push_back(static_cast<uint8_t>(val));
+		}
+
+		uint64_t Read(std::size_t& pos) const
+		{
+			uint64_t val = 0;
+			for (int shift = 0;; shift += 7)
+			{
+				uint8_t byte = deltas[pos++];
+				val |= static_cast<uint64_t>(byte & 0x7F) << shift;
+				if (!(byte & 0x80))
+					return val;
+			}
+		}
+
+		std::vector<uint8_t> deltas;
+		// position in deltas and the begin offset preceding every CHECKPOINT entries
+		std::vector<std::pair<std::size_t, std::size_t>> checkpoints;
+		// sorted by node value
+		Index index;
+		// sorted by node address
+		Index aliases;
+		std::vector<std::size_t> lines;
+		std::size_t last = 0;
+		// BOM removed by the parser
+		std::size_t base = 0;
+	};
+
+	class Parser
+	{
+	public:
+		Parser(std::istream& is, uint32_t _flags = PARSE_DEFAULT) :
+			buffer{ (std::istreambuf_iterator<char>(is)),
+				std::istreambuf_iterator<char>() },
+			flags(_flags)
+		{
+
+		}
+
+		Parser(const std::vector<char>& _buffer, uint32_t _flags = PARSE_DEFAULT) :
+			buffer(_buffer),
+			flags(_flags)
+		{
+
+		}
+
+		Parser(const char* data, size_t size, uint32_t _flags = PARSE_DEFAULT) :
+			buffer(data, data + size),
+			flags(_flags)
+		{
+
+		}
+
+		Node Parse()
+		{
+			FixEncoding();
+			detail::Scanner<detail::BufferSource> scanner{ buffer.data(), buffer.size() };
+			scanner.SetAnchors(flags & PARSE_ANCHORS);
+			return Parse(scanner);
+		}
+
+		// Also records the source range of every node into map
+		Node Parse(SourceMap& map)
+		{
+			std::size_t size = buffer.size();
+			FixEncoding();
+
+			map.Clear();
+			detail::Scanner<detail::BufferSource> scanner{ buffer.data(), buffer.size() };
+			scanner.SetAnchors(flags & PARSE_ANCHORS);
+
+			Context ctx;
+			ctx.map = &map;
+
+			Token tok;
+			bool eof = !scanner.Next(tok);
+			Node root = eof ? Node{} : Parse(scanner, tok, eof, ctx);
+
+			map.Finish(buffer, size - buffer.size());
+			return root;
+		}
+
+		// Builds the tree straight from the scanner, the input is never buffered
+		// as a whole, used for sources that do not fit the constructors above.
+		// Anchors are parsed if they are enabled on the scanner.
+		template<class Source>
+		static Node Parse(detail::Scanner<Source>& scanner)
+		{
+			Token tok;
+			bool eof = !scanner.Next(tok);
+			if (eof)
+				return {};
+
+			Context ctx;
+			return Parse(scanner, tok, eof, ctx);
+		}
+
+	private:
+		friend class BatchParser;
+
+		using Token = detail::Token;
+
+		// Places nodes and values in arena
+		template<class Source>
+		static Node Parse(detail::Scanner<Source>& scanner, detail::Arena& arena)
+		{
+			Token tok;
+			bool eof = !scanner.Next(tok);
+			if (eof)
+				return {};
+
+			Context ctx;
+			ctx.arena = &arena;
+			return Parse(scanner, tok, eof, ctx);
+		}
+
+		struct Context
+		{
+			SourceMap* map = nullptr;
+			// range of the alias just parsed, recorded once its node is placed
+			bool alias = false;
+			SourceMap::Range aliasRange{ 0, 0 };
+			// every anchor holds a reference to its value until parsing is done
+			std::map<std::string, Node> anchors;
+			// set by BatchParser
+			detail::Arena* arena = nullptr;
+		};
+
+		static void AddAlias(Context& ctx, const Node& node)
+		{
+			if (!ctx.alias)
+				return;
+
+			ctx.alias = false;
+			ctx.map->AddAlias(node, ctx.aliasRange.begin, ctx.aliasRange.end);
+		}
+
+		template<class Source>
+		static Node Parse(detail::Scanner<Source>& scanner, Token& tok, bool& eof, Context& ctx)
+		{
+			if (tok.anchor.empty())
+				return ParseValue(scanner, tok, eof, ctx);
+
+			std::string anchor = std::move(tok.anchor);
+			Node node = ParseValue(scanner, tok, eof, ctx);
+			ctx.anchors[anchor] = node.Share();
+			return node;
+		}
+
+		// Every value is built in a function of its own with a single named
+		// result, so it is constructed in place instead of being moved.
+		template<class Source>
+		static Node ParseValue(detail::Scanner<Source>& scanner, Token& tok, bool& eof, Context& ctx)
+		{
+			switch (tok.type)
+			{
+			case Token::SCALAR:
+				return ParseScalar(scanner, tok, eof, ctx);
+			case Token::ALIAS:
+				return ParseAlias(scanner, tok, eof, ctx);
+			case Token::ARRAY_START:
+				return ParseList(scanner, tok, eof, ctx);
+			case Token::DICT_START:
+				return ParseDict(scanner, tok, eof, ctx);
+			default:
+				break;
+			}
+
+			throw Error("Unexpected character", tok.pos, tok.line, tok.col);
+		}
+
+		template<class Source>
+		static Node ParseScalar(detail::Scanner<Source>& scanner, Token& tok, bool& eof, Context& ctx)
+		{
+			Node node = Node::NewScalar(ctx.arena, std::move(tok.value));
+			if (ctx.map)
+				ctx.map->Add(node, scanner.TokenStart(), scanner.TokenEnd());
+
+			eof = !scanner.Next(tok);
+			return node;
+		}
+
+		template<class Source>
+		static Node ParseAlias(detail::Scanner<Source>& scanner, Token& tok, bool& eof, Context& ctx)
+		{
+			auto anchor = ctx.anchors.find(tok.value);
+			if (anchor == ctx.anchors.end())
+				throw Error("Unknown anchor " + tok.value, tok.pos, tok.line, tok.col);
+
+			Node node = anchor->second.Share();
+			if (ctx.map)
+			{
+				ctx.alias = true;
+				ctx.aliasRange = { scanner.TokenStart(), scanner.TokenEnd() };
+			}
+
+			eof = !scanner.Next(tok);
+			return node;
+		}
+
+		// Lists and dicts are filled in place, so the children parsed so far are
+		// released with the node if the input turns out to be malformed
+		template<class Source>
+		static Node ParseList(detail::Scanner<Source>& scanner, Token& tok, bool& eof, Context& ctx)
+		{
+			std::size_t begin = scanner.TokenStart();
+			Node node = Node::NewList(ctx.arena, {});
+			auto& list = static_cast<Node::ValueList*>(node.val)->val;
+
+			eof = !scanner.Next(tok);
+			while (!eof && tok.type != Token::ARRAY_END)
+			{
+				auto& child = list.emplace_back(nullptr);
+				child = Node::NewNode(ctx.arena, Parse(scanner, tok, eof, ctx));
+				AddAlias(ctx, *child);
+			}
+
+			if (ctx.map)
+				ctx.map->Add(node, begin, tok.pos);
+
+			eof = !scanner.Next(tok);
+			return node;
+		}
+
+		template<class Source>
+		static Node ParseDict(detail::Scanner<Source>& scanner, Token& tok, bool& eof, Context& ctx)
+		{
+			std::size_t begin = scanner.TokenStart();
+			Node node = Node::NewDict(ctx.arena, {});
+			auto& dict = static_cast<Node::ValueDict*>(node.val)->val;
+
+			eof = !scanner.Next(tok);
+			while (!eof && tok.type != Token::DICT_END)
+			{
+				if (tok.type != Token::KEY)
+					throw Error("key expected", tok.pos, tok.line, tok.col);
+
+				// the first of duplicate keys wins
+				auto slot = dict.try_emplace(std::move(tok.value), nullptr);
+
+				eof = !scanner.Next(tok);
+				if (!slot.second)
+				{
+					Parse(scanner, tok, eof, ctx);
+					ctx.alias = false;
+					continue;
+				}
+
+				auto& child = slot.first->second;
+				child = Node::NewNode(ctx.arena, Parse(scanner, tok, eof, ctx));
+				AddAlias(ctx, *child);
+			}
+
+			if (ctx.map)
+				ctx.map->Add(node, begin, tok.pos);
+
+			eof = !scanner.Next(tok);
+			return node;
+		}
+
+		void FixEncoding()
+		{
+			if(buffer.size() < 3) return;
+			// If file is encoded with BOM, remove the BOM header from the buffer
+			if(buffer[0] == (char)0xEF && buffer[1] == (char)0xBB && buffer[2] == (char)0xBF)
+			{
+				buffer.erase(buffer.begin(), buffer.begin() + 3);
+			}
+		}
+
+		std::vector<char> buffer;
+		uint32_t flags;
+	};
+
+	// Parses many small documents into one shared arena. Inputs are scanned in
+	// place instead of being copied, every document costs one handle and its
+	// root node, and all of them are released together with the batch.
+	// Documents may be moved out of the batch, every block of the arena lives
+	// until the last node allocated from it is gone.
+	class BatchParser
+	{
+	public:
+		using Handle = uint32_t;
+
+		BatchParser(uint32_t _flags = PARSE_DEFAULT) :
+			flags(_flags)
+		{
+
+		}
+
+		BatchParser(const BatchParser&) = delete;
+		BatchParser& operator=(const BatchParser&) = delete;
+
+		~BatchParser()
+		{
+			for (auto& doc : docs)
+				delete doc;
+		}
+
+		Handle Parse(const char* data, std::size_t size)
+		{
+			// skip BOM header
+			if (size >= 3 && data[0] == (char)0xEF && data[1] == (char)0xBB && data[2] == (char)0xBF)
+			{
+				data += 3;
+				size -= 3;
+			}
+
+			docs.push_back(nullptr);
+
+			try
+			{
+				detail::Scanner<detail::BufferSource> scanner{ data, size };
+				scanner.SetAnchors(flags & PARSE_ANCHORS);
+				docs.back() = new Node(Parser::Parse(scanner, arena));
+			}
+			catch (...)
+			{
+				docs.pop_back();
+				throw;
+			}
+
+			return static_cast<Handle>(docs.size() - 1);
+		}
+
+		Node& operator[](Handle handle) { return *docs[handle]; }
+
+		std::size_t Size() const { return docs.size(); }
+
+	private:
+		uint32_t flags;
+		detail::Arena arena;
+		std::vector<Node*> docs;
+	};
+
+	class Emitter
+	{
+	public:
+		static void Emit(Node& node, std::ostream& os, int indent = 0, bool isLast = true)
+		{
+			std::string _indent(indent * 2, ' ');
+
+			if (node.IsScalar())
+			{
+				os << '\'' << detail::Escape(node.ToString()) << "'\n";
+			}
+			else if (node.IsList())
+			{
+				os << "[\n";
+
+				auto& list = static_cast<const Node&>(node).ToList();
+				for (auto it = list.begin(); it != list.end(); ++it)
+				{
+					os << _indent;
+					Emit(**it, os, indent + 1, std::next(it) == list.end());
+				}
+
+				os << std::string((indent - 1) * 2, ' ') << (isLast ? "]\n" : "],\n");
+			}
+			else if (node.IsDict())
+			{
+				if (indent > 0)
+					os << "{\n";
+
+				auto& dict = static_cast<const Node&>(node).ToDict();
+				for (auto it = dict.begin(); it != dict.end(); ++it)
+				{
+					if (!it->second || it->second->IsNone())
+						continue;
+
+					os << _indent << it->first << ": ";
+					Emit(*it->second, os, indent + 1, std::next(it) == dict.end());
+				}
+
+				if (indent > 0)
+					os << std::string((indent-1) * 2, ' ') << (isLast ? "}\n" : "},\n");
+			}
+		}
+
+		// Same output as Emit. The text of every top-level entry of a dict is
+		// kept on it and only entries modified since the last call are
+		// serialized again. Entries holding shared values or lists and dicts
+		// handed out by ToList() / ToDict() are serialized every time. Not
+		// synchronized.
+		static void EmitCached(Node& node, std::ostream& os)
+		{
+			if (!node.IsDict() || node.val->refs > 1)
+			{
+				Emit(node, os);
+				return;
+			}
+
+			auto value = static_cast<Node::ValueDict*>(node.val);
+			if (value->exposed)
+			{
+				value->emitted = {};
+				Emit(node, os);
+				return;
+			}
+
+			auto& dict = value->val;
+			std::vector<Node::ValueDict::Emitted> entries;
+			entries.reserve(dict.size());
+
+			// both are in key order
+			auto prev = value->emitted.begin();
+			bool clean = true;
+
+			for (auto it = dict.begin(); it != dict.end(); ++it)
+			{
+				Node* child = it->second;
+				if (!child)
+					continue;
+
+				// keep the link so assigning the key later dirties this dict
+				if (child->val->refs == 1)
+					child->val->parent = value;
+				if (child->IsNone())
+					continue;
+
+				bool isLast = std::next(it) == dict.end();
+				while (prev != value->emitted.end() && prev->key < it->first)
+					++prev;
+
+				if (prev != value->emitted.end() && prev->key == it->first && prev->value == child->val && prev->isLast == isLast && !child->val->dirty)
+				{
+					entries.push_back(std::move(*prev));
+					continue;
+				}
+
+				std::string text = it->first + ": ";
+				if (!EmitLinked(*child, text, 1, isLast))
+					clean = false;
+				entries.push_back({ it->first, child->val, isLast, std::move(text) });
+			}
+
+			for (auto& entry : entries)
+				os << entry.text;
+
+			value->emitted = std::move(entries);
+			value->linked = true;
+			if (clean)
+				value->dirty = false;
+		}
+
+	private:
+		// Appends the same text as Emit and links the lists and dicts below to
+		// their parents, so that changes dirty their ancestors. Returns false if
+		// the subtree holds shared or handed out values, changes there are not
+		// seen and the text can not be reused.
+		static bool EmitLinked(Node& node, std::string& out, int indent, bool isLast)
+		{
+			std::string _indent(indent * 2, ' ');
+			bool clean = node.val->refs == 1;
+
+			if (node.IsScalar())
+			{
+				out += '\'';
+				out += detail::Escape(node.ToString());
+				out += "'\n";
+			}
+			else if (node.IsList())
+			{
+				auto value = static_cast<Node::ValueList*>(node.val);
+				bool link = clean && !value->exposed;
+				clean = link;
+
+				out += "[\n";
+				for (auto it = value->val.begin(); it != value->val.end(); ++it)
+				{
+					Node* child = *it;
+					out += _indent;
+					if (!child)
+						continue;
+
+					if (link && child->val->refs == 1)
+						child->val->parent = value;
+					if (!EmitLinked(*child, out, indent + 1, std::next(it) == value->val.end()))
+						clean = false;
+				}
+				out += std::string((indent - 1) * 2, ' ');
+				out += isLast ? "]\n" : "],\n";
+
+				if (link)
+					value->linked = true;
+			}
+			else if (node.IsDict())
+			{
+				auto value = static_cast<Node::ValueDict*>(node.val);
+				bool link = clean && !value->exposed;
+				clean = link;
+
+				out += "{\n";
+				for (auto it = value->val.begin(); it != value->val.end(); ++it)
+				{
+					Node* child = it->second;
+					if (!child)
+						continue;
+
+					if (link && child->val->refs == 1)
+						child->val->parent = value;
+					if (child->IsNone())
+						continue;
+
+					out += _indent;
+					out += it->first;
+					out += ": ";
+					if (!EmitLinked(*child, out, indent + 1, std::next(it) == value->val.end()))
+						clean = false;
+				}
+				out += std::string((indent - 1) * 2, ' ');
+				out += isLast ? "}\n" : "},\n";
+
+				if (link)
+					value->linked = true;
+			}
+
+			// a clean value only has clean values below, see MarkDirty()
+			if (clean)
+				node.val->dirty = false;
+			return clean;
+		}
+	};
+
+	// Pull based event reader, the input is scanned chunk by chunk so memory use
+	// does not depend on the document size.
+	class Reader
+	{
+	public:
+		using Event = detail::Token;
+
+		Reader(std::istream& is, std::size_t chunkSize = 64 * 1024, uint32_t flags = PARSE_DEFAULT) :
+			scanner(is, chunkSize)
+		{
+			scanner.SetAnchors(flags & PARSE_ANCHORS);
+		}
+
+		bool Next(Event& ev) { return scanner.Next(ev); }
+
+	private:
+		detail::Scanner<detail::StreamSource> scanner;
+	};
+
+	// Writes a stream of events using the same layout as Emitter::Emit.
+	class Writer
+	{
+	public:
+		using Event = Reader::Event;
+
+		Writer(std::ostream& _os) :
+			os(_os)
+		{
+
+		}
+
+		void Write(const Event& ev)
+		{
+			switch (ev.type)
+			{
+			case Event::KEY:
+				if (frames.empty() || frames.back().isList)
+					throw Error("Key outside of a dict", ev.pos, ev.line, ev.col);
+
+				CloseValue(false);
+				os << std::string(frames.back().indent * 2, ' ') << ev.value << ": ";
+				break;
+			case Event::SCALAR:
+				BeginValue(ev);
+				os << '\'' << detail::Escape(ev.value) << "'\n";
+				break;
+			case Event::ALIAS:
+				BeginValue(ev);
+				os << '*' << ev.value << '\n';
+				break;
+			case Event::ARRAY_START:
+				BeginValue(ev);
+				os << "[\n";
+				frames.push_back({ true, frames.empty() ? 0 : frames.back().indent + 1 });
+				break;
+			case Event::DICT_START:
+				if (!frames.empty())
+				{
+					BeginValue(ev);
+					os << "{\n";
+				}
+				else if (done)
+					throw Error("Unbalanced event stream", ev.pos, ev.line, ev.col);
+				frames.push_back({ false, frames.empty() ? 0 : frames.back().indent + 1 });
+				break;
+			case Event::ARRAY_END:
+			case Event::DICT_END:
+			{
+				if (frames.empty() || frames.back().isList != (ev.type == Event::ARRAY_END))
+					throw Error("Unbalanced event stream", ev.pos, ev.line, ev.col);
+
+				CloseValue(true);
+
+				Frame frame = frames.back();
+				frames.pop_back();
+
+				if (frame.indent > 0)
+				{
+					os << std::string((frame.indent - 1) * 2, ' ') << (frame.isList ? ']' : '}');
+					pendingClose = true;
+				}
+
+				if (frames.empty())
+				{
+					CloseValue(true);
+					done = true;
+				}
+				break;
+			}
+			}
+		}
+
+		// Throws if a container is still open at the end of the input
+		void Finish()
+		{
+			if (!frames.empty())
+				throw Error("Unexpected end of input, unclosed container");
+		}
+
+	private:
+		struct Frame
+		{
+			bool isList;
+			std::size_t indent;
+		};
+
+		void BeginValue(const Event& ev)
+		{
+			if (frames.empty() && done)
+				throw Error("Unbalanced event stream", ev.pos, ev.line, ev.col);
+
+			if (!frames.empty() && frames.back().isList)
+			{
+				CloseValue(false);
+				os << std::string(frames.back().indent * 2, ' ');
+			}
+
+			if (!ev.anchor.empty())
+				os << '&' << ev.anchor << ' ';
+		}
+
+		// Containers are only followed by a comma when a sibling comes after them
+		void CloseValue(bool isLast)
+		{
+			if (!pendingClose)
+				return;
+
+			os << (isLast ? "\n" : ",\n");
+			pendingClose = false;
+		}
+
+		std::ostream& os;
+		std::vector<Frame> frames;
+		bool pendingClose = false;
+		// the top level container was closed
+		bool done = false;
+	};
+
+	// Connects a Reader to a Writer through a chain of stages. Every stage sees
+	// each key and value together with its path and may modify or drop it,
+	// dropping a key or a container drops the whole entry.
+	class Pipeline
+	{
+	public:
+		using Event = Reader::Event;
+		using Path = std::vector<std::string>;
+		using Stage = std::function<bool(Event& ev, const Path& path)>;
+
+		Pipeline& Add(Stage stage)
+		{
+			stages.push_back(std::move(stage));
+			return *this;
 		}
+
+		Pipeline& Filter(std::function<bool(const Event& ev, const Path& path)> pred)
+		{
+			return Add([pred](Event& ev, const Path& path) { return pred(ev, path); });
+		}
+
+		Pipeline& Transform(std::function<void(Event& ev, const Path& path)> func)
+		{
+			return Add([func](Event& ev, const Path& path) { func(ev, path); return true; });
+		}
+
+		void Run(Reader& reader, Writer& writer)
+		{
+			Path path;
+			std::vector<std::size_t> frames;
+			Event ev;
+			Event key;
+			bool hasKey = false;
+			bool skipValue = false;
+			std::size_t skipDepth = 0;
+
+			auto isList = [&]() { return !frames.empty() && frames.back() != SIZE_MAX; };
+			auto endValue = [&]() {
+				if (!frames.empty())
+					path.pop_back();
+			};
+
+			while (reader.Next(ev))
+			{
+				if (skipDepth > 0)
+				{
+					if (ev.type == Event::ARRAY_START || ev.type == Event::DICT_START)
+						++skipDepth;
+					else if (ev.type == Event::ARRAY_END || ev.type == Event::DICT_END)
+						--skipDepth;
+
+					if (skipDepth == 0)
+						endValue();
+					continue;
+				}
+
+				switch (ev.type)
+				{
+				case Event::KEY:
+					if (frames.empty() || frames.back() != SIZE_MAX)
+						throw Error("Key outside of a dict", ev.pos, ev.line, ev.col);
+
+					path.push_back(ev.value);
+					if (Apply(ev, path))
+					{
+						path.back() = ev.value;
+						key = ev;
+						hasKey = true;
+					}
+					else
+						skipValue = true;
+					break;
+				case Event::ARRAY_END:
+				case Event::DICT_END:
+					if (frames.empty() || (frames.back() != SIZE_MAX) != (ev.type == Event::ARRAY_END))
+						throw Error("Unbalanced event stream", ev.pos, ev.line, ev.col);
+
+					frames.pop_back();
+					writer.Write(ev);
+					endValue();
+					break;
+				default:
+				{
+					bool isStart = ev.type == Event::ARRAY_START || ev.type == Event::DICT_START;
+
+					if (isList())
+						path.push_back(std::to_string(frames.back()++));
+
+					if (skipValue || !Apply(ev, path))
+					{
+						skipValue = false;
+						hasKey = false;
+
+						if (isStart)
+							skipDepth = 1;
+						else
+							endValue();
+						break;
+					}
+
+					if (hasKey)
+					{
+						writer.Write(key);
+						hasKey = false;
+					}
+					writer.Write(ev);
+
+					if (isStart)
+						frames.push_back(ev.type == Event::ARRAY_START ? 0 : SIZE_MAX);
+					else
+						endValue();
+				}
+				}
+			}
+
+			if (!frames.empty() || skipDepth > 0)
+				throw Error("Unexpected end of input, unclosed container");
+			writer.Finish();
+		}
+
+	private:
+		bool Apply(Event& ev, const Path& path)
+		{
+			for (auto& stage : stages)
+			{
+				if (!stage(ev, path))
+					return false;
+			}
+			return true;
+		}
+
+		std::vector<Stage> stages;
 	};
 };
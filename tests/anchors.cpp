@@ -0,0 +1,129 @@
+#include "alt-config.h"
+
+#include "check.h"
+
+using namespace alt::config;
+
+static Node Parse(const std::string& text, uint32_t flags = PARSE_ANCHORS)
+{
+	Parser parser{ text.data(), text.size(), flags };
+	return parser.Parse();
+}
+
+static std::string Emit(Node& node)
+{
+	std::ostringstream os;
+	Emitter::Emit(node, os);
+	return os.str();
+}
+
+static std::vector<Lexer::Token::Kind> Kinds(const std::string& text, uint32_t flags)
+{
+	Lexer lexer{ text.data(), text.size(), flags };
+	std::vector<Lexer::Token::Kind> kinds;
+	for (auto& tok : lexer.Lex())
+		kinds.push_back(tok.kind);
+	return kinds;
+}
+
+int main()
+{
+	const std::string text = "base: &b { x: 1, y: { z: 2 } }\nother: *b\nlist: &l [ 1, 2 ]\nl2: *l\nname: &n 'v'\nn2: *n\n";
+
+	// without the flag & and * are plain text as before
+	{
+		Node root = Parse("password: *secret\nv: &abc def\nl: [ *a, &b c ]\n", PARSE_DEFAULT);
+		CHECK(root["password"].ToString() == "*secret");
+		CHECK(root["v"].ToString() == "&abc def");
+		CHECK(root["l"][std::size_t{ 0 }].ToString() == "*a");
+		CHECK(root["l"][std::size_t{ 1 }].ToString() == "&b c");
+
+		using Token = Lexer::Token;
+		CHECK((Kinds("a: &x b\nc: *x\n", PARSE_DEFAULT) == std::vector<Token::Kind>{ Token::KEY, Token::SCALAR, Token::KEY, Token::SCALAR }));
+		CHECK((Kinds("a: &x b\nc: *x\n", PARSE_ANCHORS) == std::vector<Token::Kind>{ Token::KEY, Token::ANCHOR, Token::SCALAR, Token::KEY, Token::ALIAS }));
+
+		std::istringstream is{ "a: *x\n" };
+		Reader reader{ is };
+		Reader::Event ev;
+		while (reader.Next(ev) && ev.type != Reader::Event::SCALAR)
+			CHECK(ev.type != Reader::Event::ALIAS);
+		CHECK(ev.value == "*x");
+	}
+
+	// aliases share the value of their anchor
+	{
+		Node root = Parse(text);
+		CHECK(root.Find("other")->Find("x") == root.Find("base")->Find("x"));
+		CHECK(root["other"].IsShared());
+		CHECK(root["other"]["y"]["z"].ToNumber() == 2);
+		CHECK(root["l2"][std::size_t{ 1 }].ToNumber() == 2);
+		CHECK(root["n2"].ToString() == "v");
+
+		// quoted or escaped text is never an alias, & needs a blank after the name
+		Node plain = Parse("a: '*b'\nb: \\*b\nc: &d\\ e\n");
+		CHECK(plain["a"].ToString() == "*b");
+		CHECK(plain["b"].ToString() == "\\*b");
+		CHECK(plain["c"].ToString() == "&d\\ e");
+
+		CHECK_THROWS(Parse("a: *unknown\n"));
+		CHECK_THROWS(Parse("a: &x\nb: c\n"));
+		CHECK_THROWS(Parse("a: &x &y b\n"));
+	}
+
+	// writes through an alias copy what they modify, the anchor keeps its value
+	{
+		Node root = Parse(text);
+
+		root["other"]["x"] = Node("5");
+		CHECK(root["base"]["x"].ToNumber() == 1);
+		CHECK(root["other"]["x"].ToNumber() == 5);
+
+		root["other"]["y"]["z"] = Node("7");
+		CHECK(root["base"]["y"]["z"].ToNumber() == 2);
+
+		root["base"]["y"]["z"] = Node("9");
+		CHECK(root["other"]["y"]["z"].ToNumber() == 7);
+
+		root["l2"][std::size_t{ 0 }] = Node("42");
+		CHECK(root["list"][std::size_t{ 0 }].ToNumber() == 1);
+
+		root.SetMany({ { "other.y.w", Node("3") } });
+		CHECK(!root["base"]["y"].Find("w"));
+
+		Node::Dict& other = root["other"].ToDict();
+		delete other["x"];
+		other.erase("x");
+		CHECK(root["base"]["x"].ToNumber() == 1);
+	}
+
+	// events carry the anchors, writing them back gives the same document
+	{
+		std::istringstream is{ text };
+		Reader reader{ is, 64 * 1024, PARSE_ANCHORS };
+		std::ostringstream os;
+		Writer writer{ os };
+
+		Reader::Event ev;
+		while (reader.Next(ev))
+			writer.Write(ev);
+		writer.Finish();
+
+		Node expected = Parse(text);
+		Node written = Parse(os.str());
+		CHECK(Emit(written) == Emit(expected));
+		CHECK(written["other"].IsShared());
+	}
+
+	// documents of a batch resolve their own anchors only
+	{
+		BatchParser batch{ PARSE_ANCHORS };
+		auto first = batch.Parse(text.data(), text.size());
+		CHECK(batch[first]["other"]["x"].ToNumber() == 1);
+
+		const std::string other = "a: *b\n";
+		CHECK_THROWS(batch.Parse(other.data(), other.size()));
+		CHECK(batch.Size() == 1);
+	}
+
+	return 0;
+}
@@ -0,0 +1,98 @@
+#include "alt-config-archive.h"
+
+#include "check.h"
+
+#include <filesystem>
+#include <fstream>
+
+using namespace alt::config;
+
+static std::string Emit(Node& node)
+{
+	std::ostringstream os;
+	Emitter::Emit(node, os);
+	return os.str();
+}
+
+// Copy of archive.zip with a 32 bit field of the directory entry for name
+// changed
+static std::string Corrupt(const std::string& name, std::size_t offset, uint32_t (*change)(uint32_t))
+{
+	std::ifstream in{ "archive.zip", std::ios::binary };
+	std::string data{ std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>() };
+
+	std::size_t pos = data.find(std::string("PK\x01\x02", 4));
+	while (data.compare(pos + 46, name.size(), name) != 0)
+		pos = data.find(std::string("PK\x01\x02", 4), pos + 1);
+
+	auto field = reinterpret_cast<uint8_t*>(&data[pos + offset]);
+	uint32_t value = change(detail::ReadU32(field));
+	for (int i = 0; i < 4; i++)
+		field[i] = static_cast<uint8_t>(value >> (8 * i));
+
+	std::string path = (std::filesystem::temp_directory_path() / "alt-config-test-corrupt.zip").string();
+	std::ofstream out{ path, std::ios::binary };
+	out << data;
+	return path;
+}
+
+// Parsing the changed entry has to fail
+static void CheckCorrupt(const std::string& name, std::size_t offset, uint32_t (*change)(uint32_t))
+{
+	std::string path = Corrupt(name, offset, change);
+	{
+		Archive archive{ path };
+		CHECK_THROWS(archive.Parse(name));
+	}
+	std::filesystem::remove(path);
+}
+
+// archive.zip holds stored.cfg and deflated.cfg, the latter starts with the
+// contents of the former
+int main()
+{
+	Archive archive{ "archive.zip" };
+	CHECK(archive.GetEntries().size() == 2);
+	CHECK(archive.Find("stored.cfg"));
+	CHECK(!archive.Find("missing.cfg"));
+
+	Node stored = archive.Parse("stored.cfg");
+	CHECK(stored["name"].ToString() == "server");
+	CHECK(stored["port"].ToNumber() == 7788);
+	CHECK(stored["flags"][std::size_t{ 2 }].ToString() == "c d");
+	CHECK(stored["limits"]["max"].ToString() == "18446744073709551615");
+
+	Node deflated = archive.Parse("deflated.cfg");
+	CHECK(deflated["entry199"]["id"].ToNumber() == 199);
+	CHECK(deflated["entry0"]["tags"][std::size_t{ 1 }].ToString() == "y");
+
+	// entries parse the same as their text does
+	auto is = archive.Open(*archive.Find("deflated.cfg"));
+	std::string text{ std::istreambuf_iterator<char>(*is), std::istreambuf_iterator<char>() };
+	Parser parser{ text.data(), text.size() };
+	Node expected = parser.Parse();
+	CHECK(Emit(deflated) == Emit(expected));
+
+	for (const char* key : { "name", "port", "ratio", "flags", "limits" })
+		CHECK(deflated[key].Fingerprint() == stored[key].Fingerprint());
+
+	CHECK_THROWS(archive.Parse("missing.cfg"));
+	CHECK_THROWS(Archive{ "missing.zip" });
+
+	// sizes and checksums have to match the directory, offsets: 16 crc,
+	// 20 compressed size, 24 size
+	auto plusOne = [](uint32_t v) { return v + 1; };
+	auto minusOne = [](uint32_t v) { return v - 1; };
+	auto huge = [](uint32_t) { return uint32_t{ 0xFFFFFF }; };
+	auto flip = [](uint32_t v) { return v ^ 1; };
+
+	CheckCorrupt("stored.cfg", 24, plusOne);
+	CheckCorrupt("stored.cfg", 20, huge);
+	CheckCorrupt("stored.cfg", 16, flip);
+	CheckCorrupt("deflated.cfg", 24, plusOne);
+	CheckCorrupt("deflated.cfg", 24, minusOne);
+	CheckCorrupt("deflated.cfg", 20, huge);
+	CheckCorrupt("deflated.cfg", 16, flip);
+
+	return 0;
+}
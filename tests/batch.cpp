@@ -0,0 +1,112 @@
+#include "alt-config-reclaim.h"
+
+#include "check.h"
+
+#include <new>
+
+using namespace alt::config;
+
+// arena blocks are the only aligned allocations
+static std::atomic<int> blocks{ 0 };
+
+void* operator new(std::size_t size, std::align_val_t align)
+{
+	blocks++;
+	std::size_t alignment = static_cast<std::size_t>(align);
+	if (void* ptr = std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment))
+		return ptr;
+	throw std::bad_alloc{};
+}
+
+void operator delete(void* ptr, std::align_val_t) noexcept
+{
+	blocks--;
+	std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t, std::align_val_t align) noexcept { operator delete(ptr, align); }
+
+// A malformed document releases what was parsed of it, so every block of the
+// arena is freed with the batch
+static void Malformed()
+{
+	const std::string good = "a: { b: [ 1, 2, 3 ], c: d }\n";
+	const std::string bad[] = {
+		"a: { b: [ 1, 2, 'unterminated ] }\n",
+		"a: { b: [ 1, 2 ], c }\n",
+		"a: { b: [ 1, { c: ] } ] }\n",
+		"a: { b: [ 1, 2, *unknown ] }\n",
+		"a: { b: 1, b: [ 2, *unknown ] }\n",
+	};
+
+	for (auto& text : bad)
+	{
+		{
+			BatchParser batch{ PARSE_ANCHORS };
+			batch.Parse(good.data(), good.size());
+			CHECK_THROWS(batch.Parse(text.data(), text.size()));
+			CHECK(batch.Size() == 1);
+			CHECK(batch[0]["a"]["c"].ToString() == "d");
+		}
+		CHECK(blocks == 0);
+
+		// and a plain parser leaks nothing either, see the sanitizer builds
+		Parser parser{ text.data(), text.size(), PARSE_ANCHORS };
+		CHECK_THROWS(parser.Parse());
+	}
+
+	// the first of duplicate keys is kept, the others are released
+	{
+		const std::string text = "a: 1\na: [ 2 ]\nb: 3\n";
+		BatchParser batch;
+		Node& doc = batch[batch.Parse(text.data(), text.size())];
+		CHECK(doc["a"].ToString() == "1");
+		CHECK(doc["b"].ToString() == "3");
+	}
+	CHECK(blocks == 0);
+}
+
+// Documents of a batch share its arena, which has to be freed exactly once
+// no matter which thread drops the last document
+static void AcrossThreads()
+{
+	const std::string text = "a: { b: [ 1, 2, 3 ], c: d }\n";
+
+	for (int round = 0; round < 100; round++)
+	{
+		Reclaimer reclaimer;
+		std::vector<Node> moved;
+
+		{
+			BatchParser batch;
+			for (int i = 0; i < 16; i++)
+				batch.Parse(text.data(), text.size());
+
+			for (BatchParser::Handle i = 0; i < batch.Size(); i++)
+			{
+				if (i % 2)
+					reclaimer.Retire(std::move(batch[i]));
+				else
+					moved.push_back(std::move(batch[i]));
+			}
+		}
+
+		std::thread other([docs = std::move(moved)]() mutable {
+			for (auto& doc : docs)
+				CHECK(doc["a"]["c"].ToString() == "d");
+			docs.clear();
+		});
+
+		reclaimer.Flush();
+		other.join();
+	}
+	CHECK(blocks == 0);
+}
+
+int main()
+{
+	Malformed();
+	AcrossThreads();
+
+	return 0;
+}
@@ -0,0 +1,94 @@
+#include "alt-config-binary.h"
+
+#include "check.h"
+
+using namespace alt::config;
+
+static Node Parse(const std::string& text)
+{
+	Parser parser{ text.data(), text.size() };
+	return parser.Parse();
+}
+
+static std::string Emit(Node& node)
+{
+	std::ostringstream os;
+	Emitter::Emit(node, os);
+	return os.str();
+}
+
+template<class Codec>
+static Node RoundTrip(Node& node)
+{
+	std::ostringstream os;
+	Codec::Encode(node, os);
+	std::istringstream is{ os.str() };
+	return Codec::Decode(is);
+}
+
+template<class Codec>
+static void CheckCodec()
+{
+	Node root = Parse(
+		"name: 'server'\n"
+		"port: 7788\n"
+		"offset: -12\n"
+		"ratio: 0.25\n"
+		"enabled: true\n"
+		"big: 18446744073709551615\n"
+		"text: '007'\n"
+		"list: [ a, [ 1, 2 ], { k: v } ]\n"
+		"empty: { }\n");
+
+	Node decoded = RoundTrip<Codec>(root);
+	CHECK(Emit(decoded) == Emit(root));
+
+	// values built from native types keep them, integers stay exact
+	Node native{ Node::Dict{} };
+	native["int"] = Node(static_cast<int64_t>(1234567890123456789));
+	native["negative"] = Node(static_cast<int64_t>(-9000000000000000000));
+	native["double"] = Node(2.5);
+	native["bool"] = Node(false);
+
+	Node nativeDecoded = RoundTrip<Codec>(native);
+	CHECK(nativeDecoded["int"].ToString() == "1234567890123456789");
+	CHECK(nativeDecoded["negative"].ToString() == "-9000000000000000000");
+	CHECK(nativeDecoded["double"].ToNumber() == 2.5);
+	CHECK(!nativeDecoded["bool"].ToBool());
+
+	// integers of every width decode as native integers, text stays text and
+	// integers above int64_t stay exact
+	Node ints{ Node::List{} };
+	const int64_t values[] = { 0, 1, 127, 128, 255, 256, 65535, 65536, 4294967295, 4294967296, -1, -32, -33, -128, -129,
+		-32768, -32769, -2147483648, -2147483649, std::numeric_limits<int64_t>::max(), std::numeric_limits<int64_t>::min() };
+	for (int64_t val : values)
+		ints.ToList().push_back(new Node(val));
+
+	Node intsDecoded = RoundTrip<Codec>(ints);
+	for (std::size_t i = 0; i < std::size(values); i++)
+	{
+		CHECK(intsDecoded[i].IsNative());
+		CHECK(intsDecoded[i].ToString() == std::to_string(values[i]));
+	}
+
+	CHECK(decoded["port"].IsNative() && decoded["port"].ToNumber() == 7788);
+	CHECK(decoded["offset"].IsNative() && decoded["offset"].ToNumber() == -12);
+	CHECK(!decoded["big"].IsNative() && decoded["big"].ToString() == "18446744073709551615");
+	CHECK(!decoded["text"].IsNative() && decoded["text"].ToString() == "007");
+	CHECK(nativeDecoded["int"].IsNative() && nativeDecoded["negative"].IsNative());
+
+	// truncated input is an error
+	std::ostringstream os;
+	Codec::Encode(root, os);
+	std::string truncated = os.str().substr(0, os.str().size() / 2);
+	std::istringstream is{ truncated };
+	CHECK_THROWS(Codec::Decode(is));
+}
+
+int main()
+{
+	CheckCodec<MsgPack>();
+	CheckCodec<Cbor>();
+
+	return 0;
+}
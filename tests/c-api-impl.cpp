@@ -0,0 +1,8 @@
+#define ALT_CONFIG_C_IMPLEMENTATION
+#include "alt-config-c.h"
+
+// Looks key up the way C++ hosts do, which leaves an empty entry behind
+extern "C" void test_touch(alt_config_node* node, const char* key)
+{
+	(*alt::config::detail::CNode(node))[key];
+}
@@ -0,0 +1,102 @@
+#include "alt-config-c.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CHECK(expr) \
+	do \
+	{ \
+		if (!(expr)) \
+		{ \
+			fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #expr); \
+			exit(1); \
+		} \
+	} while (0)
+
+void test_touch(alt_config_node* node, const char* key);
+
+static alt_config_node* Get(alt_config_node* node, const char* key)
+{
+	return alt_config_get(node, key, strlen(key));
+}
+
+static int ScalarIs(alt_config_node* node, const char* expected)
+{
+	const char* data;
+	size_t size;
+	if (alt_config_scalar(node, &data, &size) != ALT_CONFIG_OK)
+		return 0;
+	return size == strlen(expected) && memcmp(data, expected, size) == 0;
+}
+
+int main(void)
+{
+	const char* text = "name: 'server'\nport: 7788\nenabled: yes\nlist: [ a, b ]\nsub: { k: v }\n";
+
+	CHECK(alt_config_version() == ALT_CONFIG_C_VERSION);
+
+	alt_config_doc* doc;
+	CHECK(alt_config_parse(text, strlen(text), &doc) == ALT_CONFIG_OK);
+	alt_config_node* root = alt_config_root(doc);
+
+	CHECK(alt_config_type(root) == ALT_CONFIG_DICT);
+	CHECK(ScalarIs(Get(root, "name"), "server"));
+
+	double number;
+	CHECK(alt_config_number(Get(root, "port"), &number) == ALT_CONFIG_OK && number == 7788);
+	CHECK(alt_config_number(Get(root, "name"), &number) == ALT_CONFIG_INVALID_CAST);
+
+	int32_t flag;
+	CHECK(alt_config_bool(Get(root, "enabled"), &flag) == ALT_CONFIG_OK && flag);
+
+	alt_config_node* list = Get(root, "list");
+	CHECK(alt_config_size(list) == 2);
+	CHECK(ScalarIs(alt_config_at(list, 1), "b"));
+	CHECK(alt_config_at(list, 2) == NULL);
+	CHECK(Get(root, "missing") == NULL);
+
+	/* empty entries left by C++ lookups are not visible */
+	test_touch(root, "missing");
+	test_touch(Get(root, "sub"), "other");
+	CHECK(Get(root, "missing") == NULL);
+	CHECK(alt_config_size(root) == 5);
+	CHECK(alt_config_size(Get(root, "sub")) == 1);
+
+	alt_config_iter* entries = alt_config_iterate(Get(root, "sub"));
+	const char* entryKey;
+	size_t entryKeySize;
+	alt_config_node* entry;
+	CHECK(alt_config_next(entries, &entryKey, &entryKeySize, &entry) == ALT_CONFIG_OK);
+	CHECK(entryKeySize == 1 && entryKey[0] == 'k');
+	CHECK(alt_config_next(entries, &entryKey, &entryKeySize, &entry) == ALT_CONFIG_END);
+	alt_config_iter_free(entries);
+
+	// snapshots are independent of the document
+	alt_config_doc* snapshot;
+	CHECK(alt_config_snapshot(doc, &snapshot) == ALT_CONFIG_OK);
+	alt_config_free(doc);
+
+	alt_config_iter* iter = alt_config_iterate(alt_config_root(snapshot));
+	CHECK(iter);
+
+	const char* key;
+	size_t keySize;
+	alt_config_node* value;
+	int count = 0;
+	while (alt_config_next(iter, &key, &keySize, &value) == ALT_CONFIG_OK)
+	{
+		CHECK(keySize > 0 && value);
+		count++;
+	}
+	CHECK(count == 5);
+	alt_config_iter_free(iter);
+
+	CHECK(ScalarIs(Get(Get(alt_config_root(snapshot), "sub"), "k"), "v"));
+	alt_config_free(snapshot);
+
+	CHECK(alt_config_parse("a: 'x", 5, &doc) == ALT_CONFIG_ERROR);
+	CHECK(strlen(alt_config_error()) > 0);
+
+	return 0;
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstdlib>
+#include <iostream>
+
+// Unlike assert this also checks in release builds
+#define CHECK(expr) \
+	do \
+	{ \
+		if (!(expr)) \
+		{ \
+			std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK(" #expr ") failed\n"; \
+			std::exit(1); \
+		} \
+	} while (false)
+
+// Passes if stmt throws alt::config::Error
+#define CHECK_THROWS(stmt) \
+	do \
+	{ \
+		bool thrown = false; \
+		try \
+		{ \
+			stmt; \
+		} \
+		catch (const alt::config::Error&) \
+		{ \
+			thrown = true; \
+		} \
+		CHECK(thrown && #stmt); \
+	} while (false)
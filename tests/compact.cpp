@@ -0,0 +1,102 @@
+#include "alt-config.h"
+
+#include "check.h"
+
+using namespace alt::config;
+
+static Node Parse(const std::string& text)
+{
+	Parser parser{ text.data(), text.size() };
+	return parser.Parse();
+}
+
+static std::string Emit(Node& node)
+{
+	std::ostringstream os;
+	Emitter::Emit(node, os);
+	return os.str();
+}
+
+int main()
+{
+	std::string text;
+	for (int i = 0; i < 200; i++)
+		text += "entry" + std::to_string(i) + ": { id: " + std::to_string(i) + ", tags: [ x, y, 'a text too long for the small string buffer' ], on: yes }\n";
+
+	// compaction keeps the contents, empty nodes are dropped
+	{
+		Node root = Parse(text);
+		for (int i = 0; i < 200; i += 3)
+			root["entry" + std::to_string(i)]["id"] = Node(static_cast<int64_t>(i * 2));
+		CHECK(root["entry1"]["missing"].IsNone());
+		root["entry2"]["ratio"] = Node(0.5);
+
+		std::string before = Emit(root);
+		uint64_t fingerprint = root.Fingerprint();
+
+		root.Compact();
+		CHECK(Emit(root) == before);
+		CHECK(root.Fingerprint() == fingerprint);
+		CHECK(!root["entry1"].Find("missing"));
+		CHECK(root["entry3"]["id"].ToNumber() == 6);
+		CHECK(root["entry2"]["ratio"].ToNumber() == 0.5);
+
+		// writes on a compacted tree, references taken before SetMany stay valid
+		Node& id = root["entry5"]["id"];
+		root.SetMany({ { "entry5.extra", Node("new") }, { "added.deep", Node(true) } });
+		CHECK(id.ToNumber() == 5);
+		CHECK(root["added"]["deep"].ToBool());
+
+		// children handed out through ToDict() may be deleted by the caller
+		auto& dict = root["entry7"].ToDict();
+		delete dict["tags"];
+		dict.erase("tags");
+		CHECK(!root["entry7"].Find("tags"));
+
+		auto& list = root["entry8"]["tags"].ToList();
+		delete list.back();
+		list.pop_back();
+		CHECK(root["entry8"]["tags"].ToList().size() == 2);
+
+		// compacting again releases the first arena
+		root.Compact();
+		CHECK(root["entry8"]["tags"][std::size_t{ 1 }].ToString() == "y");
+	}
+
+	// values outlive the tree they were compacted with
+	{
+		Node kept;
+		{
+			Node root = Parse(text);
+			root.Compact();
+			kept = std::move(root["entry150"]);
+		}
+		CHECK(kept["tags"][std::size_t{ 2 }].ToStringView().size() == 43);
+		CHECK(kept["id"].ToNumber() == 150);
+
+		Node shared;
+		{
+			Node root = Parse(text);
+			root.Compact();
+			shared = root["entry10"]["tags"].Share();
+		}
+		CHECK(shared[std::size_t{ 0 }].ToString() == "x");
+	}
+
+	// documents of a batch outlive the batch
+	{
+		Node moved;
+		{
+			BatchParser batch;
+			for (int i = 0; i < 100; i++)
+				batch.Parse(text.data(), text.size());
+			moved = std::move(batch[57]);
+		}
+		CHECK(moved["entry199"]["id"].ToNumber() == 199);
+		for (auto& curr : moved["entry199"].ToDict())
+			delete curr.second;
+		moved["entry199"].ToDict().clear();
+	}
+
+	return 0;
+}
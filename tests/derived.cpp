@@ -0,0 +1,108 @@
+#include "alt-config-derived.h"
+
+#include "check.h"
+
+using namespace alt::config;
+
+static Node Parse(const std::string& text)
+{
+	Parser parser{ text.data(), text.size() };
+	return parser.Parse();
+}
+
+int main()
+{
+	// recomputed only when one of the paths read changed
+	{
+		DerivedRegistry registry;
+		Node root = Parse("grid: { size: 4, cells: [ 1, 2, 3 ] }\nname: x\n");
+		registry.Update(root);
+
+		int computed = 0;
+		Derived<double> sum{ [&](DerivedRegistry::Inputs& inputs) {
+			computed++;
+			double result = inputs.Get("grid.size")->ToNumber();
+			for (auto& cell : inputs.Get("grid.cells")->ToList())
+				result += cell->ToNumber();
+			return result;
+		}, registry };
+
+		CHECK(sum.IsStale());
+		CHECK(sum.Get() == 10 && computed == 1);
+		CHECK(sum.Get() == 10 && computed == 1);
+
+		root["name"] = Node("y");
+		registry.Update(root);
+		CHECK(!sum.IsStale());
+
+		root["grid"]["size"] = Node(5);
+		registry.Update(root);
+		CHECK(sum.IsStale());
+		CHECK(sum == 11 && computed == 2);
+
+		// an equal reload keeps the value
+		Node reloaded = Parse("grid: { size: 5, cells: [ 1, 2, 3 ] }\nname: z\n");
+		registry.Update(reloaded);
+		CHECK(!sum.IsStale());
+		registry.Update(root);
+	}
+
+	// edits through references and containers held from before are seen
+	{
+		DerivedRegistry registry;
+		Node root = Parse("a: { b: 1, c: [ x, y ] }\n");
+		registry.Update(root);
+
+		Node& b = root["a"]["b"];
+		Node::Dict& a = root["a"].ToDict();
+		Node::List& c = root["a"]["c"].ToList();
+
+		Derived<std::string> joined{ [](DerivedRegistry::Inputs& inputs) {
+			std::string result = inputs.Get("a.b")->ToString();
+			for (auto& item : static_cast<const Node*>(inputs.Get("a.c"))->ToList())
+				result += item->ToString();
+			return result;
+		}, registry };
+		Derived<std::size_t> keys{ [](DerivedRegistry::Inputs& inputs) {
+			return static_cast<const Node*>(inputs.Get("a"))->ToDict().size();
+		}, registry };
+
+		CHECK(joined.Get() == "1xy" && keys.Get() == 2);
+
+		b = Node("2");
+		registry.Update(root);
+		CHECK(joined.IsStale() && keys.IsStale());
+		CHECK(joined.Get() == "2xy" && keys.Get() == 2);
+
+		c.push_back(new Node("z"));
+		registry.Update(root);
+		CHECK(joined.Get() == "2xyz");
+
+		*c[0] = Node("w");
+		registry.Update(root);
+		CHECK(joined.Get() == "2wyz");
+
+		a.emplace("d", new Node("e"));
+		registry.Update(root);
+		CHECK(keys.IsStale() && !joined.IsStale());
+		CHECK(keys.Get() == 3);
+	}
+
+	// missing inputs are tracked too
+	{
+		DerivedRegistry registry;
+		Node root = Parse("a: 1\n");
+
+		Derived<bool> has{ [](DerivedRegistry::Inputs& inputs) { return inputs.Get("x.y") != nullptr; }, registry };
+		CHECK_THROWS(has.Get());
+
+		registry.Update(root);
+		CHECK(!has.Get());
+
+		root.SetMany({ { "x.y", Node(true) } });
+		registry.Update(root);
+		CHECK(has.IsStale() && has.Get());
+	}
+
+	return 0;
+}
@@ -0,0 +1,130 @@
+#include "alt-config.h"
+
+#include "check.h"
+
+using namespace alt::config;
+
+static Node Parse(const std::string& text)
+{
+	Parser parser{ text.data(), text.size() };
+	return parser.Parse();
+}
+
+static std::string Emit(Node& node)
+{
+	std::ostringstream os;
+	Emitter::Emit(node, os);
+	return os.str();
+}
+
+// cached output has to match a full emit after every change
+static void CheckCached(Node& node)
+{
+	std::string expected = Emit(node);
+	for (int i = 0; i < 2; i++)
+	{
+		std::ostringstream os;
+		Emitter::EmitCached(node, os);
+		CHECK(os.str() == expected);
+	}
+}
+
+int main()
+{
+	const std::string text =
+		"name: 'server'\n"
+		"nested: { x: { y: [ 1, [ 2, 3 ] ] } }\n"
+		"list: [ a, { b: c } ]\n"
+		"z: last\n";
+
+	// writes through lookups dirty the entries above them
+	{
+		Node root = Parse(text);
+		CheckCached(root);
+
+		root["nested"]["x"]["z"] = Node("new");
+		CheckCached(root);
+
+		root["list"][std::size_t{ 1 }]["b"] = Node("d");
+		CheckCached(root);
+
+		root["zz"] = Node("after the last");
+		CheckCached(root);
+
+		root["name"] = Node(42);
+		CheckCached(root);
+
+		root.SetMany({ { "nested.x.w", Node("set") }, { "a", Node("first") } });
+		CheckCached(root);
+
+		Node moved = std::move(root["list"]);
+		CheckCached(root);
+		root["name"] = std::move(moved);
+		CheckCached(root);
+
+		std::swap(root["z"], root["zz"]);
+		CheckCached(root);
+
+		root["nested"]["x"].Compact();
+		CheckCached(root);
+
+		root["nested"]["x"]["y"][std::size_t{ 0 }] = Node("one");
+		CheckCached(root);
+	}
+
+	// containers handed out for writing may change after the cache was filled
+	{
+		Node root = Parse(text);
+
+		Node::Dict& dict = root["nested"]["x"].ToDict();
+		CheckCached(root);
+		delete dict["y"];
+		dict["y"] = new Node("replaced");
+		CheckCached(root);
+		delete dict["y"];
+		dict.erase("y");
+		CheckCached(root);
+
+		Node::List& list = root["list"].ToList();
+		CheckCached(root);
+		list.push_back(new Node("e"));
+		CheckCached(root);
+		std::swap(list[0], list[2]);
+		CheckCached(root);
+
+		Node::Dict& top = root.ToDict();
+		CheckCached(root);
+		top["inserted"] = new Node("x");
+		CheckCached(root);
+		delete top["name"];
+		top.erase("name");
+		CheckCached(root);
+	}
+
+	// shared values are emitted every time and never go stale
+	{
+		Node root = Parse(text);
+		CheckCached(root);
+
+		Node snapshot = root["nested"].Share();
+		CheckCached(root);
+		root["nested"]["x"]["y"] = Node("changed");
+		CheckCached(root);
+		CheckCached(snapshot);
+		CHECK(snapshot["x"]["y"].IsList());
+	}
+
+	// a copy starts without a cache
+	{
+		Node root = Parse(text);
+		CheckCached(root);
+
+		Node copy = root;
+		copy["name"] = Node("copy");
+		CheckCached(copy);
+		CheckCached(root);
+		CHECK(root["name"].ToString() == "server");
+	}
+
+	return 0;
+}
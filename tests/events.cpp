@@ -0,0 +1,81 @@
+#include "alt-config.h"
+
+#include "check.h"
+
+using namespace alt::config;
+
+static std::string RunPipeline(const std::string& text, Pipeline& pipeline)
+{
+	std::istringstream is{ text };
+	Reader reader{ is };
+	std::ostringstream os;
+	Writer writer{ os };
+	pipeline.Run(reader, writer);
+	return os.str();
+}
+
+static std::string RunWriter(const std::string& text)
+{
+	std::istringstream is{ text };
+	Reader reader{ is };
+	std::ostringstream os;
+	Writer writer{ os };
+
+	Reader::Event ev;
+	while (reader.Next(ev))
+		writer.Write(ev);
+	writer.Finish();
+
+	return os.str();
+}
+
+static Node Parse(const std::string& text)
+{
+	Parser parser{ text.data(), text.size() };
+	return parser.Parse();
+}
+
+static std::string Emit(Node& node)
+{
+	std::ostringstream os;
+	Emitter::Emit(node, os);
+	return os.str();
+}
+
+int main()
+{
+	const std::string text = "a: { b: [ 1, 2, { c: d } ] }\ne: f\ng: [ ]\n";
+
+	// passing every event through gives the same document
+	{
+		Pipeline pipeline;
+		Node expected = Parse(text);
+		Node piped = Parse(RunPipeline(text, pipeline));
+		CHECK(Emit(piped) == Emit(expected));
+
+		Node written = Parse(RunWriter(text));
+		CHECK(Emit(written) == Emit(expected));
+	}
+
+	// stages see the path of every event
+	{
+		Pipeline pipeline;
+		pipeline.Filter([](const Pipeline::Event&, const Pipeline::Path& path) {
+			return path.empty() || path[0] != "e";
+		});
+
+		Node filtered = Parse(RunPipeline(text, pipeline));
+		CHECK(filtered["e"].IsNone());
+		CHECK(filtered["a"]["b"][std::size_t{ 2 }]["c"].ToString() == "d");
+	}
+
+	// unbalanced input is an error instead of a crash
+	for (const char* bad : { "}key: ''", "a: { b: 1", "a: 1 }", "a: [ 1, 2", "a: 1 ] ]", "a: [ 1 }", "a: { b: 1 ]", "}}", "]" })
+	{
+		Pipeline pipeline;
+		CHECK_THROWS(RunPipeline(bad, pipeline));
+		CHECK_THROWS(RunWriter(bad));
+	}
+
+	return 0;
+}
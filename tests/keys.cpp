@@ -0,0 +1,95 @@
+#include "alt-config.h"
+
+#include "check.h"
+
+#include <new>
+
+using namespace alt::config;
+using namespace alt::config::literals;
+
+// counts every allocation of the test
+static std::size_t allocations = 0;
+
+// Not inlined, GCC would pair the malloc() and free() inside with the new and
+// delete expressions of the test and warn about a mismatch
+[[gnu::noinline]] void* operator new(std::size_t size)
+{
+	allocations++;
+	if (void* ptr = std::malloc(size ? size : 1))
+		return ptr;
+	throw std::bad_alloc{};
+}
+
+void* operator new[](std::size_t size) { return operator new(size); }
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+	allocations++;
+	return std::malloc(size ? size : 1);
+}
+
+[[gnu::noinline]] void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { operator delete(ptr); }
+void operator delete[](void* ptr) noexcept { operator delete(ptr); }
+void operator delete[](void* ptr, std::size_t) noexcept { operator delete(ptr); }
+
+static Node Parse(const std::string& text)
+{
+	Parser parser{ text.data(), text.size() };
+	return parser.Parse();
+}
+
+// Every key of root is found by its literal and missing ones are not,
+// without allocating
+static void CheckLookups(Node& root)
+{
+	const Node& croot = root;
+
+	// the hash index and the empty node are created on first use
+	CHECK(croot["missing"_key].IsNone());
+
+	std::size_t before = allocations;
+	CHECK(root.Find("name"_key)->ToStringView() == "server");
+	CHECK(root.Find("port"_key)->ToStringView() == "7788");
+	CHECK(croot["name"_key].ToStringView() == "server");
+	CHECK(!root.Find("missing"_key));
+	CHECK(croot["missing"_key].IsNone());
+	CHECK(!root.Find("nam"_key) && !root.Find("names"_key));
+	// too long for the small string buffer
+	CHECK(root.Find("a_key_longer_than_sso_buffers"_key)->ToStringView() == "long");
+	CHECK(!root.Find("a_key_longer_than_sso_buffers_"_key));
+	CHECK(allocations == before);
+
+	CHECK(root["name"_key].ToString() == "server");
+}
+
+int main()
+{
+	static_assert(("port"_key).Hash() == detail::Hash("port"));
+	constexpr Key runtime{ "port", 4 };
+	static_assert(runtime.Hash() == ("port"_key).Hash());
+
+	std::string small = "name: server\nport: 7788\na_key_longer_than_sso_buffers: long\n";
+	std::string large = small;
+	for (int i = 0; i < 20; i++)
+		large += "key" + std::to_string(i) + ": " + std::to_string(i) + "\n";
+
+	// plain map, hash index, frozen map and perfect hash
+	for (const std::string& text : { small, large })
+	{
+		Node root = Parse(text);
+		CheckLookups(root);
+
+		root.Freeze();
+		CheckLookups(root);
+	}
+
+	// inserting through a literal adds the key, the index picks it up
+	Node root = Parse(large);
+	CHECK(root.Find("key3"_key)->ToNumber() == 3);
+	root["added"_key] = Node("yes");
+	CHECK(root.Find("added"_key)->ToBool());
+	CHECK(root.Find(Key{ std::string{ "key19" } })->ToNumber() == 19);
+
+	return 0;
+}
@@ -0,0 +1,93 @@
+#include "alt-config.h"
+
+#include "check.h"
+
+using namespace alt::config;
+
+using Token = Lexer::Token;
+
+static bool Same(const std::vector<Token>& a, const std::vector<Token>& b)
+{
+	if (a.size() != b.size())
+		return false;
+
+	for (std::size_t i = 0; i < a.size(); i++)
+	{
+		if (a[i].offset != b[i].offset || a[i].length != b[i].length || a[i].kind != b[i].kind ||
+			a[i].escaped != b[i].escaped || a[i].quoted != b[i].quoted)
+			return false;
+	}
+	return true;
+}
+
+// Re-lexing after an edit gives the same tokens as lexing the new text
+static void CheckRelex(std::string text, std::size_t offset, std::size_t erase, const std::string& insert)
+{
+	Lexer lexer{ text.data(), text.size() };
+	lexer.Lex();
+
+	text.replace(offset, erase, insert);
+	const auto& relexed = lexer.Relex(text.data(), text.size(), offset);
+
+	Lexer fresh{ text.data(), text.size() };
+	CHECK(Same(relexed, fresh.Lex()));
+}
+
+int main()
+{
+	const std::string text = "\xEF\xBB\xBF# comment\nname: 'ser\\'ver'\nport: 7788\nlist: [ a, \"b c\" ]\nsub: { k: v\\n }\n";
+
+	Lexer lexer{ text.data(), text.size() };
+	const auto& tokens = lexer.Lex();
+
+	const Token::Kind kinds[] = {
+		Token::KEY, Token::SCALAR,
+		Token::KEY, Token::SCALAR,
+		Token::KEY, Token::ARRAY_START, Token::SCALAR, Token::SCALAR, Token::ARRAY_END,
+		Token::KEY, Token::DICT_START, Token::KEY, Token::SCALAR, Token::DICT_END
+	};
+	CHECK(tokens.size() == std::size(kinds));
+	for (std::size_t i = 0; i < tokens.size(); i++)
+		CHECK(tokens[i].kind == kinds[i]);
+
+	// raw text is a view of the buffer, values are only unescaped on request
+	CHECK(lexer.Raw(tokens[0]) == "name");
+	CHECK(tokens[1].quoted && tokens[1].escaped);
+	CHECK(lexer.Raw(tokens[1]) == "ser\\'ver");
+	CHECK(lexer.Value(tokens[1]) == "ser'ver");
+	CHECK(lexer.Raw(tokens[3]).data() == text.data() + text.find("7788"));
+	CHECK(!tokens[3].escaped && lexer.Value(tokens[3]) == "7788");
+	CHECK(lexer.Value(tokens[7]) == "b c");
+
+	// and match what the parser makes of them
+	Parser parser{ text.data(), text.size() };
+	Node root = parser.Parse();
+	CHECK(lexer.Value(tokens[12]) == root["sub"]["k"].ToString());
+	CHECK(lexer.Value(tokens[1]) == root["name"].ToString());
+
+	// Next() yields the same tokens one at a time
+	Lexer single{ text.data(), text.size() };
+	std::vector<Token> streamed;
+	Token tok;
+	while (single.Next(tok))
+		streamed.push_back(tok);
+	CHECK(Same(streamed, tokens));
+
+	std::size_t line, column;
+	lexer.Locate(tokens[2].offset, line, column);
+	CHECK(line == 3 && column == 0);
+
+	CheckRelex(text, text.find("7788"), 4, "80");
+	CheckRelex(text, text.find("7788") + 4, 0, ", extra: 1");
+	CheckRelex(text, text.find("ver'"), 0, "x");
+	CheckRelex(text, text.find("\"b c\""), 5, "[ nested ]");
+	CheckRelex(text, text.find("# comment"), 0, "first: 1\n");
+	CheckRelex(text, text.size(), 0, "last: { a: b }\n");
+	CheckRelex(text, text.find(" ]"), 2, "");
+
+	std::string unterminated = "a: 'b";
+	Lexer broken{ unterminated.data(), unterminated.size() };
+	CHECK_THROWS(broken.Lex());
+
+	return 0;
+}
@@ -0,0 +1,102 @@
+#include "alt-config.h"
+
+#include "check.h"
+
+#include <thread>
+
+using namespace alt::config;
+using Native = detail::NativeScalar;
+
+static Node Parse(const std::string& text)
+{
+	Parser parser{ text.data(), text.size() };
+	return parser.Parse();
+}
+
+static std::string Emit(Node& node)
+{
+	std::ostringstream os;
+	Emitter::Emit(node, os);
+	return os.str();
+}
+
+int main()
+{
+	// bools and numbers are stored as they are and formatted on demand
+	{
+		Node flag(true);
+		Node count(static_cast<int64_t>(-9000000000000000000));
+		Node ratio(0.25);
+		Node small(7);
+
+		CHECK(flag.IsNative() && count.IsNative() && ratio.IsNative() && small.IsNative());
+		CHECK(flag.ToBool());
+		CHECK(count.ToString() == "-9000000000000000000");
+		CHECK(ratio.ToNumber() == 0.25);
+		CHECK(ratio.ToString() == "0.25");
+		CHECK(small.ToNumber() == 7);
+		CHECK_THROWS(flag.ToNumber());
+		CHECK_THROWS(count.ToBool());
+
+		CHECK(flag.ToNative().kind == Native::BOOL);
+		CHECK(count.ToNative().kind == Native::INT && count.ToNative().i == -9000000000000000000);
+		CHECK(small.ToNative().kind == Native::UINT && small.ToNative().u == 7);
+		CHECK(ratio.ToNative().kind == Native::DOUBLE);
+
+		// beyond int64_t a uint64_t becomes a double like before
+		Node huge(std::numeric_limits<uint64_t>::max());
+		CHECK(huge.ToNative().kind == Native::DOUBLE);
+
+		// copies stay native
+		Node copy = count;
+		CHECK(copy.IsNative() && copy.ToString() == count.ToString());
+	}
+
+	// emitted text is what the string constructors made of the values
+	{
+		Node native{ Node::Dict{} };
+		native["a"] = Node(false);
+		native["b"] = Node(static_cast<int64_t>(42));
+		native["c"] = Node(1.5);
+		native["d"] = Node(std::vector<int>{ 1, 2 });
+
+		Node text{ Node::Dict{} };
+		text["a"] = Node("false");
+		text["b"] = Node("42");
+		text["c"] = Node("1.5");
+		text["d"] = Node(std::vector<std::string>{ "1", "2" });
+
+		CHECK(Emit(native) == Emit(text));
+		CHECK(native.Fingerprint() == text.Fingerprint());
+		CHECK(native["d"][std::size_t{ 0 }].IsNative());
+	}
+
+	// parsed scalars keep their text, only exact formatting counts as native
+	{
+		Node root = Parse("a: 1.50\nb: 007\nc: 12\nd: -0\ne: true\nf: 1e3\ng: 0.5\n");
+		CHECK(!root["a"].IsNative() && root["a"].ToString() == "1.50");
+		CHECK(root["a"].ToNumber() == 1.5);
+
+		CHECK(root["a"].ToNative().kind == Native::STRING);
+		CHECK(root["b"].ToNative().kind == Native::STRING);
+		CHECK(root["c"].ToNative().kind == Native::UINT && root["c"].ToNative().u == 12);
+		CHECK(root["d"].ToNative().kind == Native::STRING);
+		CHECK(root["e"].ToNative().kind == Native::BOOL && root["e"].ToNative().b);
+		CHECK(root["f"].ToNative().kind == Native::STRING);
+		CHECK(root["g"].ToNative().kind == Native::DOUBLE);
+		CHECK(Native::Classify("18446744073709551616").kind == Native::STRING);
+	}
+
+	// a shared value may be formatted on several threads at once
+	for (int round = 0; round < 100; round++)
+	{
+		Node value(static_cast<int64_t>(round));
+		Node shared = value.Share();
+
+		std::thread other([&shared, round]() { CHECK(shared.ToString() == std::to_string(round)); });
+		CHECK(value.ToString() == std::to_string(round));
+		other.join();
+	}
+
+	return 0;
+}
@@ -0,0 +1,55 @@
+#include "alt-config.h"
+
+#include "check.h"
+
+using namespace alt::config;
+
+static Node Parse(const std::string& text)
+{
+	Parser parser{ text.data(), text.size() };
+	return parser.Parse();
+}
+
+static std::string Emit(Node& node)
+{
+	std::ostringstream os;
+	Emitter::Emit(node, os);
+	return os.str();
+}
+
+int main()
+{
+	const std::string text =
+		"\xEF\xBB\xBF"
+		"# comment\n"
+		"name: 'server'\n"
+		"port: 7788\n"
+		"enabled: yes\n"
+		"flags: [ a, b, 'c, d' ]\n"
+		"nested: { x: { y: [ 1, [ 2, 3 ] ] } }\n";
+
+	Node root = Parse(text);
+	CHECK(root["name"].ToString() == "server");
+	CHECK(root["port"].ToNumber() == 7788);
+	CHECK(root["enabled"].ToBool());
+	CHECK(root["flags"][std::size_t{ 2 }].ToString() == "c, d");
+	CHECK(root["nested"]["x"]["y"][std::size_t{ 1 }][std::size_t{ 0 }].ToNumber() == 2);
+	CHECK(root["missing"].IsNone());
+
+	// emitted text parses back to the same tree
+	std::string emitted = Emit(root);
+	Node again = Parse(emitted);
+	CHECK(Emit(again) == emitted);
+	CHECK(again.Fingerprint() == root.Fingerprint());
+
+	// the streaming scanner builds the same tree from small chunks
+	std::istringstream is{ text };
+	detail::Scanner<detail::StreamSource> scanner{ is, 4 };
+	Node streamed = Parser::Parse(scanner);
+	CHECK(Emit(streamed) == emitted);
+
+	CHECK_THROWS(Parse("a: 'unterminated"));
+	CHECK_THROWS(root["name"].ToList());
+
+	return 0;
+}
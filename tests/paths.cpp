@@ -0,0 +1,99 @@
+#include "alt-config.h"
+
+#include "check.h"
+
+using namespace alt::config;
+
+static Node Parse(const std::string& text)
+{
+	Parser parser{ text.data(), text.size() };
+	return parser.Parse();
+}
+
+static std::string Emit(Node& node)
+{
+	std::ostringstream os;
+	Emitter::Emit(node, os);
+	return os.str();
+}
+
+int main()
+{
+	const std::string text = "server: { net: { port: 7788, host: localhost }, name: test }\nlist: [ a ]\nflag: yes\n";
+
+	// results are in the order of the paths, misses are nullptr
+	{
+		Node root = Parse(text);
+		std::string before = Emit(root);
+
+		auto nodes = root.GetMany({ "server.net.port", "flag", "server.name", "server.net.port", "server.missing.x", "flag.x", "list.a", "server.net", "" });
+		CHECK(nodes.size() == 9);
+		CHECK(nodes[0] == root.Find("server")->Find("net")->Find("port"));
+		CHECK(nodes[0]->ToNumber() == 7788);
+		CHECK(nodes[1]->ToBool());
+		CHECK(nodes[2]->ToString() == "test");
+		CHECK(nodes[3] == nodes[0]);
+		CHECK(!nodes[4] && !nodes[5] && !nodes[6] && !nodes[8]);
+		CHECK(nodes[7]->IsDict());
+
+		// lookups do not insert
+		CHECK(Emit(root) == before);
+	}
+
+	// assigning creates the dicts on the way, later entries win
+	{
+		Node root = Parse(text);
+		root.SetMany({
+			{ "server.net.port", Node(8080) },
+			{ "server.limits.players", Node(128) },
+			{ "new.deep.key", Node("value") },
+			{ "server.name", Node("first") },
+			{ "server.name", Node("second") },
+		});
+
+		CHECK(root["server"]["net"]["port"].ToNumber() == 8080);
+		CHECK(root["server"]["net"]["host"].ToString() == "localhost");
+		CHECK(root["server"]["limits"]["players"].ToNumber() == 128);
+		CHECK(root["new"]["deep"]["key"].ToString() == "value");
+		CHECK(root["server"]["name"].ToString() == "second");
+
+		CHECK_THROWS(root.SetMany({ { "flag.x", Node("1") } }));
+		CHECK(root["flag"].ToBool());
+	}
+
+	// the same as one lookup per path
+	{
+		Node batched = Parse(text);
+		Node single = Parse(text);
+
+		std::vector<std::pair<std::string, Node>> entries;
+		std::vector<std::string> paths;
+		for (int i = 0; i < 300; i++)
+		{
+			std::string path = "s" + std::to_string(i % 7) + ".g" + std::to_string(i % 13) + ".k" + std::to_string(i);
+			entries.push_back({ path, Node(i) });
+			paths.push_back(path);
+
+			single.SetMany({ entries.back() });
+		}
+
+		batched.SetMany(entries);
+		CHECK(Emit(batched) == Emit(single));
+
+		auto nodes = batched.GetMany(paths);
+		for (int i = 0; i < 300; i++)
+			CHECK(nodes[i] && nodes[i]->ToNumber() == i);
+	}
+
+	// a frozen tree is unfrozen where it is written to
+	{
+		Node root = Parse(text);
+		root.Freeze();
+		root.SetMany({ { "server.net.port", Node(1) }, { "other", Node(2) } });
+		CHECK(root["server"]["net"]["port"].ToNumber() == 1);
+		CHECK(root["other"].ToNumber() == 2);
+		CHECK(root.GetMany({ "server.name" })[0]->ToString() == "test");
+	}
+
+	return 0;
+}
@@ -0,0 +1,70 @@
+#include "alt-config.h"
+
+#include "check.h"
+
+using namespace alt::config;
+
+// Frozen dicts of 8 and more keys are looked up through a minimal perfect
+// hash table, smaller ones through the map
+static void CheckFrozen(std::size_t count)
+{
+	Node root{ Node::Dict{} };
+	for (std::size_t i = 0; i < count; i++)
+		root["key" + std::to_string(i)] = Node(static_cast<int64_t>(i));
+	root.Freeze();
+
+	const Node& croot = root;
+	for (std::size_t i = 0; i < count; i++)
+	{
+		std::string key = "key" + std::to_string(i);
+		CHECK(croot[key].ToNumber() == i);
+		CHECK(root[key].ToNumber() == i);
+		CHECK(root.Find(Key{ key })->ToNumber() == i);
+	}
+
+	// misses land in slots of other keys
+	for (std::size_t i = count; i < count * 4; i++)
+	{
+		std::string key = "key" + std::to_string(i);
+		CHECK(!root.Find(Key{ key }));
+		CHECK(croot[key].IsNone());
+		CHECK_THROWS(root[key]);
+	}
+	CHECK(!root.Find(Key{ "" }));
+	CHECK(!root.Find(Key{ "key" }));
+
+	// the empty node of a miss is not shared with anything writable
+	CHECK(croot["missing"].IsNone());
+	CHECK(croot.ToDict().size() == count);
+}
+
+int main()
+{
+	for (std::size_t count : { 1, 7, 8, 9, 16, 100, 1000, 5000 })
+		CheckFrozen(count);
+
+	// nested frozen dicts get their own tables
+	Node root{ Node::Dict{} };
+	for (int i = 0; i < 10; i++)
+	{
+		Node& sub = root["sub" + std::to_string(i)] = Node{ Node::Dict{} };
+		for (int j = 0; j < 10; j++)
+			sub["key" + std::to_string(j)] = Node(static_cast<int64_t>(i * 10 + j));
+	}
+	root.Freeze();
+
+	const Node& croot = root;
+	for (int i = 0; i < 10; i++)
+	{
+		for (int j = 0; j < 10; j++)
+			CHECK(croot["sub" + std::to_string(i)]["key" + std::to_string(j)].ToNumber() == i * 10 + j);
+	}
+	CHECK(croot["sub3"]["key10"].IsNone());
+
+	// modifying a dict unfreezes it, new keys are found
+	root["sub3"].ToDict()["key10"] = new Node("x");
+	CHECK(root["sub3"]["key10"].ToString() == "x");
+	CHECK(root["sub3"]["key11"].IsNone());
+
+	return 0;
+}
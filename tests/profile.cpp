@@ -0,0 +1,57 @@
+#include "alt-config-profile.h"
+
+#include "check.h"
+
+using namespace alt::config;
+
+static std::string Emit(Node& node)
+{
+	std::ostringstream os;
+	Emitter::Emit(node, os);
+	return os.str();
+}
+
+int main()
+{
+	std::string text = "name: 'server'\nlist: [ 1, 2, { a: b } ]\n";
+	for (int i = 0; i < 1000; i++)
+		text += "key" + std::to_string(i) + ": 'value " + std::to_string(i) + "'\n";
+
+	Profiler profiler;
+	Profiler::Report report;
+
+	// measured calls give the same results as plain ones
+	Parser parser{ text.data(), text.size() };
+	Node root = profiler.Parse(parser, text.size(), report);
+	CHECK(root["name"].ToString() == "server");
+	CHECK(root["key999"].ToString() == "value 999");
+	CHECK(report.bytes == text.size() && report.nanoseconds > 0);
+
+	Lexer lexer{ text.data(), text.size() };
+	const auto& tokens = profiler.Lex(lexer, text.size(), report);
+	CHECK(tokens.size() > 2000);
+	CHECK(&tokens == &lexer.Lex());
+	CHECK(report.bytes == text.size());
+
+	std::ostringstream os;
+	profiler.Emit(root, os, report);
+	CHECK(os.str() == Emit(root));
+	CHECK(report.bytes == os.str().size());
+
+	// counters are optional, if there are any they count something
+	if (profiler.HasCounters())
+		CHECK(report.cycles || report.instructions || report.branchMisses || report.cacheMisses);
+	else
+		CHECK(!report.cycles && !report.instructions && !report.branchMisses && !report.cacheMisses);
+
+	std::ostringstream printed;
+	printed << report;
+	CHECK(printed.str().find(std::to_string(report.bytes) + " bytes") == 0);
+
+	// failures propagate, empty reports do not divide by zero
+	Parser bad{ "a: 'x", 5 };
+	CHECK_THROWS(profiler.Parse(bad, 5, report));
+	CHECK(Profiler::Report{}.PerByte(10) == 0);
+
+	return 0;
+}
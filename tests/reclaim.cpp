@@ -0,0 +1,71 @@
+#include "alt-config-reclaim.h"
+
+#include "check.h"
+
+using namespace alt::config;
+
+static Node Parse(const std::string& text)
+{
+	Parser parser{ text.data(), text.size() };
+	return parser.Parse();
+}
+
+int main()
+{
+	const std::string text = "a: { b: [ 1, 2, 3 ], c: d }\n";
+
+	// trees are destroyed on the background thread
+	{
+		Reclaimer reclaimer;
+
+		std::thread::id destroyedOn;
+		std::shared_ptr<Node> doc{ new Node(Parse(text)), [&](Node* node) {
+			destroyedOn = std::this_thread::get_id();
+			delete node;
+		} };
+		std::weak_ptr<Node> watch = doc;
+
+		reclaimer.Retire(std::move(doc));
+		reclaimer.Flush();
+		CHECK(watch.expired());
+		CHECK(destroyedOn != std::thread::id{} && destroyedOn != std::this_thread::get_id());
+
+		Node root = Parse(text);
+		reclaimer.Retire(std::move(root));
+		CHECK(root.IsNone());
+		reclaimer.Flush();
+	}
+
+	// a tree still referenced elsewhere survives its retirement
+	{
+		Reclaimer reclaimer;
+
+		auto doc = std::make_shared<Node>(Parse(text));
+		reclaimer.Retire(std::shared_ptr<Node>(doc));
+		reclaimer.Flush();
+		CHECK((*doc)["a"]["c"].ToString() == "d");
+	}
+
+	// destroying the reclaimer drains the queue
+	std::size_t destroyed = 0;
+	{
+		Reclaimer reclaimer;
+		for (int i = 0; i < 100; i++)
+			reclaimer.Retire(std::shared_ptr<Node>(new Node(Parse(text)), [&](Node* node) {
+				destroyed++;
+				delete node;
+			}));
+	}
+	CHECK(destroyed == 100);
+
+	// the deleter hands trees to the global reclaimer
+	std::weak_ptr<Node> watch;
+	{
+		std::shared_ptr<Node> doc{ new Node(Parse(text)), Reclaimer::Deleter{} };
+		watch = doc;
+	}
+	Reclaimer::Global().Flush();
+	CHECK(watch.expired());
+
+	return 0;
+}
@@ -0,0 +1,94 @@
+#include "alt-config-registry.h"
+
+#include "check.h"
+
+#include <thread>
+
+using namespace alt::config;
+
+static std::string Write(const std::string& name, const std::string& text)
+{
+	std::string path = (std::filesystem::temp_directory_path() / name).string();
+	std::ofstream file{ path, std::ios::binary | std::ios::trunc };
+	file << text;
+	return path;
+}
+
+int main()
+{
+	std::string a = Write("alt-config-test-a.cfg", "name: a\nlist: [ 1, 2, 3 ]\n");
+	std::string b = Write("alt-config-test-b.cfg", "name: b\n");
+
+	// cached documents are shared until the file changes
+	{
+		DocumentRegistry registry;
+		auto first = registry.Load(a);
+		CHECK((*first)["name"].ToString() == "a");
+		CHECK((*first)["missing"].IsNone());
+		CHECK(registry.Load(a) == first);
+		CHECK(registry.GetMemoryUsage() > 0);
+
+		Write("alt-config-test-a.cfg", "name: changed\n");
+		auto second = registry.Load(a);
+		CHECK(second != first);
+		CHECK((*second)["name"].ToString() == "changed");
+		CHECK((*first)["name"].ToString() == "a");
+
+		registry.Invalidate(a);
+		CHECK(registry.Load(a) != second);
+
+		CHECK_THROWS(registry.Load(a + ".missing"));
+	}
+
+	// content hashes catch changes that keep size and modification time
+	{
+		DocumentRegistry registry{ 1024 * 1024, DocumentRegistry::Validation::CONTENT_HASH };
+		auto first = registry.Load(b);
+		auto mtime = std::filesystem::last_write_time(b);
+		Write("alt-config-test-b.cfg", "name: c\n");
+		std::filesystem::last_write_time(b, mtime);
+
+		CHECK((*registry.Load(b))["name"].ToString() == "c");
+	}
+
+	// only documents nobody holds are evicted
+	{
+		DocumentRegistry registry;
+		auto held = registry.Load(a);
+		registry.Load(b);
+		std::size_t both = registry.GetMemoryUsage();
+
+		registry.SetBudget(0);
+		CHECK(registry.GetMemoryUsage() > 0 && registry.GetMemoryUsage() < both);
+		CHECK(registry.Load(a) == held);
+
+		held.reset();
+		registry.SetBudget(0);
+		CHECK(registry.GetMemoryUsage() == 0);
+	}
+
+	// concurrent loads of the same files while they are invalidated
+	{
+		DocumentRegistry registry;
+		std::vector<std::thread> threads;
+		for (int t = 0; t < 8; t++)
+		{
+			threads.emplace_back([&, t]() {
+				for (int i = 0; i < 50; i++)
+				{
+					auto doc = registry.Load(t % 2 ? a : b);
+					CHECK(doc && doc->IsDict() && (*doc)["missing"]["x"].IsNone());
+					if (i % 10 == 0)
+						registry.Invalidate(a);
+				}
+			});
+		}
+		for (auto& thread : threads)
+			thread.join();
+	}
+
+	std::filesystem::remove(a);
+	std::filesystem::remove(b);
+
+	return 0;
+}
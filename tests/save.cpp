@@ -0,0 +1,88 @@
+#include "alt-config-save.h"
+
+#include "check.h"
+
+using namespace alt::config;
+
+static Node Parse(const std::string& text)
+{
+	Parser parser{ text.data(), text.size() };
+	return parser.Parse();
+}
+
+static std::string Emit(Node& node)
+{
+	std::ostringstream os;
+	Emitter::Emit(node, os);
+	return os.str();
+}
+
+static std::string Read(const std::string& path)
+{
+	std::ifstream file{ path, std::ios::binary };
+	return { std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>() };
+}
+
+int main()
+{
+	std::string path = (std::filesystem::temp_directory_path() / "alt-config-test-save.cfg").string();
+
+	// the saved file is the document as it was when the save was requested,
+	// also if it is written through references taken before
+	{
+		// large enough for the save to still run during the writes
+		std::string text = "a: { b: 1, c: [ x, y ] }\nd: e\n";
+		for (int i = 0; i < 20000; i++)
+			text += "k" + std::to_string(i) + ": [ 'some text', 'to escape \\n' ]\n";
+
+		Node root = Parse(text);
+		Node& b = root["a"]["b"];
+		Node::List& c = root["a"]["c"].ToList();
+		std::string expected = Emit(root);
+
+		Saver saver;
+		auto saved = saver.SaveAsync(root, path);
+		for (int i = 0; i < 1000; i++)
+		{
+			b = Node(static_cast<int64_t>(i));
+			root["d"] = Node(i % 2 == 0);
+			c.push_back(new Node("z"));
+		}
+		saved.get();
+
+		CHECK(Read(path) == expected);
+		CHECK(!std::filesystem::exists(path + ".tmp"));
+	}
+
+	// saves run in order, the last one wins
+	{
+		Node root = Parse("v: 0\n");
+
+		Saver saver;
+		std::vector<std::future<void>> saves;
+		for (int i = 1; i <= 10; i++)
+		{
+			root["v"] = Node(i);
+			saves.push_back(saver.SaveAsync(root, path));
+		}
+		for (auto& save : saves)
+			save.get();
+
+		CHECK(Read(path) == Emit(root));
+
+		// pending saves are written when the saver goes away
+		root["v"] = Node("last");
+		saver.SaveAsync(root, path);
+	}
+	CHECK(Parse(Read(path))["v"].ToString() == "last");
+
+	// errors are reported through the future
+	{
+		Node root = Parse("v: 0\n");
+		auto failed = SaveAsync(root, (std::filesystem::temp_directory_path() / "alt-config-missing" / "x.cfg").string());
+		CHECK_THROWS(failed.get());
+	}
+
+	std::filesystem::remove(path);
+	return 0;
+}
@@ -0,0 +1,123 @@
+#include "alt-config-reflect.h"
+
+#include "check.h"
+
+using namespace alt::config;
+
+namespace
+{
+	struct Wheel
+	{
+		std::string model;
+		double radius;
+	};
+	ALT_CONFIG_FIELDS(Wheel, model, radius)
+
+	struct Vehicle
+	{
+		std::string name;
+		int seats;
+		bool electric;
+		std::vector<Wheel> wheels;
+		std::map<std::string, std::vector<int>> gears;
+		std::deque<std::string> tags;
+	};
+	ALT_CONFIG_FIELDS(Vehicle, name, seats, electric, wheels, gears, tags)
+
+	struct Limits
+	{
+		int64_t min;
+		uint64_t max;
+		double ratio;
+		bool enabled;
+		std::vector<std::string> tags;
+	};
+	ALT_CONFIG_FIELDS(Limits, min, max, ratio, enabled, tags)
+}
+
+static Node Parse(const std::string& text)
+{
+	Parser parser{ text.data(), text.size() };
+	return parser.Parse();
+}
+
+static std::string Emit(Node& node)
+{
+	std::ostringstream os;
+	Emitter::Emit(node, os);
+	return os.str();
+}
+
+int main()
+{
+	Vehicle vehicle{ "it's \"quoted\"\nand multi-line", 4, true,
+		{ { "front", 0.35 }, { "rear", 0.4 } },
+		{ { "manual", { 1, 2, 3 } }, { "auto", { } } },
+		{ "a", "b\\c" } };
+
+	// text has the layout and escaping of Emitter::Emit and parses back
+	{
+		std::ostringstream os;
+		Serializer::Emit(vehicle, os);
+		Node parsed = Parse(os.str());
+
+		CHECK(parsed["name"].ToString() == vehicle.name);
+		CHECK(parsed["seats"].ToNumber() == 4);
+		CHECK(parsed["electric"].ToBool());
+		CHECK(parsed["wheels"][std::size_t{ 1 }]["model"].ToString() == "rear");
+		CHECK(parsed["wheels"][std::size_t{ 1 }]["radius"].ToNumber() == 0.4);
+		CHECK(parsed["gears"]["manual"][std::size_t{ 2 }].ToNumber() == 3);
+		CHECK(parsed["gears"]["auto"].IsList());
+		CHECK(parsed["tags"][std::size_t{ 1 }].ToString() == "b\\c");
+
+		// keys of a map are sorted like those of a dict, so the text matches
+		std::map<std::string, Wheel> wheels{ { "b", { "x", 1 } }, { "a", { "y'", 2.5 } } };
+		std::ostringstream map;
+		Serializer::Emit(wheels, map);
+
+		Node built{ Node::Dict{} };
+		built["a"] = Node(Node::Dict{});
+		built["b"] = Node(Node::Dict{});
+		built["b"]["model"] = Node("x");
+		built["b"]["radius"] = Node(1.0);
+		built["a"]["model"] = Node("y'");
+		built["a"]["radius"] = Node(2.5);
+		CHECK(map.str() == Emit(built));
+	}
+
+	// MessagePack output decodes to the same tree as the text
+	{
+		std::ostringstream text;
+		Serializer::Emit(vehicle, text);
+		Node parsed = Parse(text.str());
+
+		std::ostringstream packed;
+		Serializer::EncodeMsgPack(vehicle, packed);
+		std::istringstream is{ packed.str() };
+		Node decoded = MsgPack::Decode(is);
+		CHECK(Emit(decoded) == Emit(parsed));
+		CHECK(decoded["seats"].IsNative());
+	}
+
+	// integers are formatted and encoded exactly
+	{
+		Limits limits{ -1234567890123456789, 18446744073709551615ull, 0.5, true, { "a", "b" } };
+
+		std::ostringstream text;
+		Serializer::Emit(limits, text);
+		Node parsed = Parse(text.str());
+		CHECK(parsed["min"].ToString() == "-1234567890123456789");
+		CHECK(parsed["max"].ToString() == Node(limits.max).ToString());
+		CHECK(parsed["ratio"].ToNumber() == 0.5);
+		CHECK(parsed["tags"][std::size_t{ 1 }].ToString() == "b");
+
+		std::ostringstream packed;
+		Serializer::EncodeMsgPack(limits, packed);
+		std::istringstream unpacked{ packed.str() };
+		Node decoded = MsgPack::Decode(unpacked);
+		CHECK(decoded["min"].ToString() == "-1234567890123456789");
+		CHECK(decoded["enabled"].ToBool());
+	}
+
+	return 0;
+}
@@ -0,0 +1,90 @@
+#include "alt-config-settings.h"
+
+#include "check.h"
+
+#include <thread>
+
+using namespace alt::config;
+
+static Node Parse(const std::string& text)
+{
+	Parser parser{ text.data(), text.size() };
+	return parser.Parse();
+}
+
+// Setting::Get() may run while the registry loads a new document
+static void Reload()
+{
+	SettingsRegistry registry;
+	Setting<std::string> name{ "server.name", "none", nullptr, registry };
+	Setting<int> port{ "server.port", 1, nullptr, registry };
+
+	std::atomic<bool> stop{ false };
+	std::thread reader([&]() {
+		while (!stop)
+		{
+			std::string curr = name;
+			CHECK(curr == "none" || curr.size() == 32);
+			CHECK(port.Get() >= 1);
+		}
+	});
+
+	for (int i = 1; i < 500; i++)
+	{
+		Node root = Parse("server: { name: '" + std::string(32, 'a' + i % 26) + "', port: " + std::to_string(i) + " }");
+		registry.Load(root);
+		CHECK(port.Get() == i);
+	}
+
+	stop = true;
+	reader.join();
+}
+
+// Integers are converted exactly, failures keep every previous value
+static void Convert()
+{
+	SettingsRegistry registry;
+	Setting<int64_t> big{ "big", 0, nullptr, registry };
+	Setting<uint64_t> max{ "max", 0, nullptr, registry };
+	Setting<int8_t> small{ "small", 0, nullptr, registry };
+	Setting<unsigned> positive{ "positive", 0, nullptr, registry };
+	Setting<double> ratio{ "ratio", 0.5, nullptr, registry };
+	Setting<bool> enabled{ "enabled", false, nullptr, registry };
+	Setting<std::string> name{ "name", "none", [](const std::string& val) { return !val.empty(); }, registry };
+
+	CHECK(ratio == 0.5 && name.Get() == "none");
+
+	Node root = Parse("big: 9007199254740993\nmax: 18446744073709551615\nsmall: -128\npositive: 1e3\nratio: 0.25\nenabled: yes\nname: x\n");
+	registry.Load(root);
+	CHECK(big == 9007199254740993);
+	CHECK(max == std::numeric_limits<uint64_t>::max());
+	CHECK(small == -128);
+	CHECK(positive == 1000);
+	CHECK(ratio == 0.25);
+	CHECK(enabled);
+	CHECK(name.Get() == "x");
+
+	root["big"] = Node(static_cast<int64_t>(-9007199254740993));
+	registry.Load(root);
+	CHECK(big == -9007199254740993);
+
+	for (const char* text : { "small: 128", "small: -129", "positive: -1", "big: 9223372036854775808", "big: 1.5", "name: ''" })
+	{
+		Node bad = Parse(text);
+		CHECK_THROWS(registry.Load(bad));
+		CHECK(big == -9007199254740993 && small == -128 && positive == 1000 && name.Get() == "x");
+	}
+
+	// missing values go back to the default
+	Node empty = Parse("other: 1");
+	registry.Load(empty);
+	CHECK(big == 0 && name.Get() == "none" && ratio == 0.5);
+}
+
+int main()
+{
+	Reload();
+	Convert();
+
+	return 0;
+}
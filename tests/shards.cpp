@@ -0,0 +1,106 @@
+#include "alt-config-shards.h"
+
+#include "check.h"
+
+#include <thread>
+
+using namespace alt::config;
+
+static std::filesystem::path dir = std::filesystem::temp_directory_path() / "alt-config-test-shards";
+
+static std::string Write(const std::string& name, const std::string& text)
+{
+	std::filesystem::path path = dir / name;
+	std::filesystem::create_directories(path.parent_path());
+	std::ofstream file{ path, std::ios::binary | std::ios::trunc };
+	file << text;
+	return path.string();
+}
+
+int main()
+{
+	std::string index = Write("index.cfg",
+		"players: 'players.cfg'\n"
+		"region-eu: 'regions/eu.cfg'\n"
+		"region-us: './regions/../regions/us.cfg'\n"
+		"limits: 'players.cfg'\n"
+		"gone: 'players.cfg'\n");
+	Write("players.cfg", "players: { max: 64 }\nlimits: [ 1, 2 ]\n");
+	Write("regions/eu.cfg", "region-eu: { name: eu }\n");
+	Write("regions/us.cfg", "region-us: { name: us }\n");
+
+	// shards are loaded on first access only, keys of one file share it
+	{
+		DocumentRegistry registry;
+		ShardedConfig config{ index, registry };
+
+		CHECK(config.Keys().size() == 5);
+		CHECK(config.Contains("region-eu") && !config.Contains("region-asia"));
+		CHECK(!config.IsLoaded("players") && !config.IsLoaded("region-eu"));
+
+		auto players = config.Get("players");
+		CHECK((*players)["max"].ToNumber() == 64);
+		CHECK(config.IsLoaded("players") && config.IsLoaded("limits"));
+		CHECK(!config.IsLoaded("region-eu"));
+
+		auto limits = config["limits"];
+		CHECK(limits->ToList().size() == 2);
+		CHECK(registry.Load((dir / "players.cfg").string())->Find("limits") == limits.get());
+
+		CHECK((*config["region-us"])["name"].ToString() == "us");
+		CHECK(!config.IsLoaded("region-eu"));
+
+		// listed in the index but not in its shard
+		CHECK(config.Get("gone") == nullptr);
+		CHECK(config.Get("region-asia") == nullptr);
+		CHECK(!config.IsLoaded("region-asia"));
+	}
+
+	// a shard nobody holds can be evicted and is loaded again on access
+	{
+		DocumentRegistry registry;
+		ShardedConfig config{ index, registry };
+
+		auto eu = config.Get("region-eu");
+		config.Get("region-us");
+		registry.SetBudget(0);
+		CHECK(config.IsLoaded("region-eu"));
+		CHECK(!config.IsLoaded("region-us"));
+
+		eu.reset();
+		registry.SetBudget(0);
+		CHECK(!config.IsLoaded("region-eu"));
+
+		registry.SetBudget(1024 * 1024);
+		CHECK((*config["region-eu"])["name"].ToString() == "eu");
+		CHECK(config.IsLoaded("region-eu"));
+	}
+
+	// concurrent first accesses
+	{
+		DocumentRegistry registry;
+		ShardedConfig config{ index, registry };
+
+		std::vector<std::thread> threads;
+		for (int t = 0; t < 8; t++)
+		{
+			threads.emplace_back([&, t]() {
+				for (int i = 0; i < 50; i++)
+				{
+					auto doc = config.Get(t % 2 ? "region-eu" : "players");
+					CHECK(doc && doc->IsDict());
+				}
+			});
+		}
+		for (auto& thread : threads)
+			thread.join();
+	}
+
+	CHECK_THROWS(ShardedConfig{ (dir / "missing.cfg").string() });
+	CHECK_THROWS(ShardedConfig{ Write("bad.cfg", "a: [ b ]\n") });
+	CHECK_THROWS(ShardedConfig{ Write("list.cfg", "[ a ]\n") });
+
+	std::filesystem::remove_all(dir);
+
+	return 0;
+}
@@ -0,0 +1,65 @@
+#include "alt-config.h"
+
+#include "check.h"
+
+using namespace alt::config;
+
+static Node Parse(const std::string& text)
+{
+	Parser parser{ text.data(), text.size(), PARSE_ANCHORS };
+	return parser.Parse();
+}
+
+static std::string Emit(Node& node)
+{
+	std::ostringstream os;
+	Emitter::Emit(node, os);
+	return os.str();
+}
+
+static std::string EmitCached(Node& node)
+{
+	std::ostringstream os;
+	Emitter::EmitCached(node, os);
+	return os.str();
+}
+
+int main()
+{
+	const std::string text = "base: &b { x: 1, y: { z: 2 } }\nother: *b\nlist: &l [ 1, 2 ]\nl2: *l\n";
+
+	// lookups on a frozen document neither copy nor insert, even through aliases
+	{
+		Node root = Parse(text);
+		root.Freeze();
+
+		const Node& croot = root;
+		CHECK(root["other"].IsShared());
+		CHECK(croot["other"]["missing"].IsNone());
+		CHECK(croot["other"]["y"]["missing"].IsNone());
+		CHECK_THROWS(root["other"]["missing"]);
+		CHECK(static_cast<const Node&>(root["other"]).ToDict().size() == 2);
+		CHECK(root["other"].IsShared());
+		CHECK(root.Find("other")->Find("x") == root.Find("base")->Find("x"));
+	}
+
+	// snapshots are not affected by later writes, cached output stays right
+	{
+		Node root = Parse(text);
+		std::string before = EmitCached(root);
+
+		Node snapshot = root.Share();
+		uint64_t fingerprint = snapshot.Fingerprint();
+
+		root["base"]["y"]["z"] = Node("11");
+		root["other"]["x"] = Node("8");
+		CHECK(EmitCached(root) == Emit(root));
+		CHECK(EmitCached(root) != before);
+
+		CHECK(EmitCached(snapshot) == before);
+		CHECK(snapshot.Fingerprint() == fingerprint);
+		CHECK(root.Fingerprint() != fingerprint);
+	}
+
+	return 0;
+}
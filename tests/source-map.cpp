@@ -0,0 +1,79 @@
+#include "alt-config.h"
+
+#include "check.h"
+
+using namespace alt::config;
+
+static std::string Source(const std::string& text, const SourceMap& map, const Node& node)
+{
+	SourceMap::Range range;
+	CHECK(map.Find(node, range));
+	return text.substr(range.begin, range.end - range.begin);
+}
+
+int main()
+{
+	// scalar ranges end at the last character, aliases have their own
+	{
+		const std::string text = "a: &x 'anc'\nc: { d: e   , f: g }\nl: [ *x , h\t]\nm: *x\n";
+
+		SourceMap map;
+		Parser parser{ text.data(), text.size(), PARSE_ANCHORS };
+		Node root = parser.Parse(map);
+		const Node& croot = root;
+
+		CHECK(Source(text, map, root["c"]["d"]) == "e");
+		CHECK(Source(text, map, root["c"]["f"]) == "g");
+		CHECK(Source(text, map, root["a"]) == "'anc'");
+		CHECK(Source(text, map, root["m"]) == "*x");
+		CHECK(Source(text, map, *croot["l"].ToList()[0]) == "*x");
+		CHECK(Source(text, map, *croot["l"].ToList()[1]) == "h");
+		CHECK(Source(text, map, root["l"]) == "[ *x , h\t]");
+		CHECK(map.Size() == 9);
+
+		// the range follows a moved node, a new value has none
+		Node moved = std::move(root["c"]["d"]);
+		CHECK(Source(text, map, moved) == "e");
+		SourceMap::Range range;
+		root["c"]["f"] = Node("x");
+		CHECK(!map.Find(root["c"]["f"], range));
+
+		map.Clear();
+		CHECK(map.Size() == 0);
+		CHECK(!map.Find(root["a"], range));
+	}
+
+	// lines start at 1 and columns at 0, offsets decode past many checkpoints
+	{
+		std::string text;
+		for (int i = 0; i < 200; i++)
+			text += "k" + std::to_string(i) + ": [ v" + std::to_string(i) + " ]\n";
+
+		SourceMap map;
+		Parser parser{ text.data(), text.size() };
+		Node root = parser.Parse(map);
+		CHECK(map.Size() == 401);
+
+		for (int i = 0; i < 200; i++)
+		{
+			Node& list = root["k" + std::to_string(i)];
+			CHECK(Source(text, map, list[std::size_t{ 0 }]) == "v" + std::to_string(i));
+
+			SourceMap::Range range;
+			CHECK(map.Find(list, range));
+			std::size_t line, column;
+			map.Locate(range.begin, line, column);
+			CHECK(line == static_cast<std::size_t>(i) + 1);
+			CHECK(column == std::to_string(i).size() + 3);
+		}
+	}
+
+	// without a map nothing is recorded
+	{
+		const std::string text = "a: b\n";
+		Parser parser{ text.data(), text.size() };
+		CHECK(parser.Parse()["a"].ToString() == "b");
+	}
+
+	return 0;
+}
@@ -0,0 +1,107 @@
+#include "alt-config-settings.h"
+
+#include "check.h"
+
+#include <thread>
+
+using namespace alt::config;
+
+static Node Parse(const std::string& text)
+{
+	Parser parser{ text.data(), text.size() };
+	return parser.Parse();
+}
+
+static std::string Emit(Node& node)
+{
+	std::ostringstream os;
+	Emitter::Emit(node, os);
+	return os.str();
+}
+
+// Values come from the document, changes are written back only once
+static void WriteBack()
+{
+	Node root = Parse("server: { tick: 30, ratio: 0.5, voice: yes }\n");
+	Tunable<int> tick{ "server.tick", 20 };
+	Tunable<double> ratio{ "server.ratio", 1 };
+	Tunable<bool> voice{ "server.voice", false };
+	Tunable<uint16_t> distance{ "server.stream.distance", 500 };
+
+	tick.Load(root);
+	ratio.Load(root);
+	voice.Load(root);
+	distance.Load(root);
+	CHECK(tick == 30 && ratio == 0.5 && voice && distance == 500);
+	CHECK(!tick.WriteBack(root));
+
+	tick = 60;
+	distance.Set(1000);
+	CHECK(tick.Get() == 60);
+	CHECK(tick.WriteBack(root));
+	CHECK(!tick.WriteBack(root));
+	CHECK(distance.WriteBack(root));
+	CHECK(root["server"]["tick"].ToNumber() == 60);
+	CHECK(root["server"]["stream"]["distance"].ToNumber() == 1000);
+
+	// written values parse back the same
+	Node again = Parse(Emit(root));
+	Tunable<int> other{ "server.tick", 0 };
+	other.Load(again);
+	CHECK(other == 60);
+
+	// Load drops pending changes
+	tick = 90;
+	tick.Load(root);
+	CHECK(tick == 60 && !tick.WriteBack(root));
+
+	// values that do not convert are rejected
+	Tunable<int8_t> small{ "server.tick", 0 };
+	Node big = Parse("server: { tick: 300 }\n");
+	CHECK_THROWS(small.Load(big));
+	CHECK(small == 0);
+}
+
+// Readers on other threads see every stored value whole
+static void Concurrent()
+{
+	Node root = Parse("rate: 0\n");
+	Tunable<int64_t> rate{ "rate", 0 };
+
+	std::atomic<bool> stop{ false };
+	std::vector<std::thread> readers;
+	for (int t = 0; t < 4; t++)
+	{
+		readers.emplace_back([&]() {
+			int64_t last = 0;
+			while (!stop)
+			{
+				int64_t curr = rate;
+				CHECK(curr >= last && curr % 0x100000001 == 0);
+				last = curr;
+			}
+		});
+	}
+
+	for (int64_t i = 1; i <= 10000; i++)
+	{
+		rate = i * 0x100000001;
+		if (i % 100 == 0)
+			rate.WriteBack(root);
+	}
+
+	stop = true;
+	for (auto& reader : readers)
+		reader.join();
+
+	CHECK(!rate.WriteBack(root));
+	CHECK(root["rate"].ToNumber() == 10000.0 * 0x100000001);
+}
+
+int main()
+{
+	WriteBack();
+	Concurrent();
+
+	return 0;
+}
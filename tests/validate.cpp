@@ -0,0 +1,134 @@
+#include "alt-config-validate.h"
+
+#include "check.h"
+
+#include <thread>
+
+using namespace alt::config;
+
+static Node Parse(const std::string& text)
+{
+	Parser parser{ text.data(), text.size() };
+	return parser.Parse();
+}
+
+int main()
+{
+	// unchanged sections are not validated again, failures are cached too
+	{
+		ValidationCache cache;
+		int runs = 0;
+		auto port = [&](const Node& node) {
+			runs++;
+			if (node["port"].ToNumber() > 65535)
+				throw Error("Port out of range");
+		};
+
+		Node root = Parse("a: { port: 80 }\nb: { port: 80 }\nc: { port: 70000 }\n");
+		cache.Validate(root["a"], "port", port);
+		cache.Validate(root["b"], "port", port);
+		CHECK(runs == 1);
+		CHECK_THROWS(cache.Validate(root["c"], "port", port));
+		CHECK_THROWS(cache.Validate(root["c"], "port", port));
+		CHECK(runs == 2 && cache.Size() == 2);
+
+		// validators are told apart by id
+		cache.Validate(root["a"], "other", [](const Node&) {});
+		CHECK(cache.Size() == 3);
+
+		root["a"]["port"] = Node(81);
+		cache.Validate(root["a"], "port", port);
+		CHECK(runs == 3);
+
+		// empty entries left by lookups do not count
+		root["b"]["missing"];
+		cache.Validate(root["b"], "port", port);
+		CHECK(runs == 3);
+
+		cache.Sweep();
+		cache.Validate(root["a"], "port", port);
+		cache.Sweep();
+		CHECK(cache.Size() == 1);
+		cache.Clear();
+		CHECK(cache.Size() == 0);
+	}
+
+	// edits through containers and references held from before are seen
+	{
+		ValidationCache cache;
+		int runs = 0;
+		auto small = [&](const Node& node) {
+			runs++;
+			if (node.ToDict().size() > 2 || node.ToDict().at("x")->ToList().size() > 2)
+				throw Error("Too large");
+		};
+
+		Node root = Parse("a: { x: [ 1 ], y: 2 }\n");
+		Node::Dict& a = root["a"].ToDict();
+		Node::List& x = root["a"]["x"].ToList();
+		Node& y = root["a"]["y"];
+
+		cache.Validate(root["a"], "small", small);
+		CHECK(runs == 1);
+
+		x.push_back(new Node(2));
+		x.push_back(new Node(3));
+		CHECK_THROWS(cache.Validate(root["a"], "small", small));
+		CHECK(runs == 2);
+
+		delete x.back();
+		x.pop_back();
+		a.emplace("z", new Node(3));
+		CHECK_THROWS(cache.Validate(root["a"], "small", small));
+		CHECK(runs == 3);
+
+		delete a["z"];
+		a.erase("z");
+		y = Node(5);
+		cache.Validate(root["a"], "small", small);
+		CHECK(runs == 4);
+	}
+
+	// frozen documents read by several threads are not written to
+	{
+		ValidationCache cache;
+		std::string text;
+		for (int i = 0; i < 100; i++)
+			text += "s" + std::to_string(i) + ": { port: " + std::to_string(i) + ", list: [ a, b ] }\n";
+
+		Node root = Parse(text);
+		uint64_t fingerprint = root.Fingerprint();
+		root.Freeze();
+
+		std::vector<Node> snapshots;
+		for (int t = 0; t < 4; t++)
+			snapshots.push_back(root.Share());
+
+		auto check = [](const Node& node) {
+			if (node["list"].ToList().size() != 2)
+				throw Error("Bad list");
+		};
+
+		std::vector<std::thread> threads;
+		for (int t = 0; t < 4; t++)
+		{
+			threads.emplace_back([&, t]() {
+				Node& snapshot = snapshots[t];
+				const Node& croot = root;
+				for (int i = 0; i < 100; i++)
+				{
+					cache.Validate(croot["s" + std::to_string(i)], "list", check);
+					cache.Validate(snapshot["s" + std::to_string(i)], "list", check);
+					CHECK(croot.Fingerprint() == fingerprint);
+					CHECK(snapshot.Fingerprint() == fingerprint);
+				}
+			});
+		}
+		for (auto& thread : threads)
+			thread.join();
+
+		CHECK(cache.Size() == 100);
+	}
+
+	return 0;
+}